@@ -0,0 +1,135 @@
+#!/usr/bin/env python3
+#
+# Converts a kernel trace dump (see include/ktrace.h and ktracedump()) to
+# Chrome trace JSON, which chrome://tracing and ui.perfetto.dev load.
+#
+#   ktrace2json.py console.log > trace.json
+#
+# The input is a raw capture of the console; the dump is found by its
+# magic number, so text printed around it does no harm.  Each process is
+# shown as a thread, with a slice for each system call and an instant for
+# each other event; a separate "hart 0" track has a slice for each stretch
+# a process ran between context switches.
+#
+
+import json
+import struct
+import sys
+
+KTRACE_MAGIC = 0x52544B58
+KTRACE_VERSION = 1
+
+HEADER = struct.Struct("<IIIIQQQQQ")
+EVENT = struct.Struct("<QIIQQ")
+
+# Must follow the KT_* IDs in include/ktrace.h
+NAMES = {
+    1: "resched",
+    2: "ctxsw",
+    3: "trap",
+    4: "irq",
+    5: "syscall",
+    6: "sysret",
+    7: "pgalloc",
+    8: "clock",
+    9: "user",
+}
+KT_CTXSW, KT_SYSCALL, KT_SYSRET = 2, 5, 6
+
+SYSCALLS = [
+    "none", "yield", "sleep", "kill", "open", "close", "read", "write",
+    "getc", "putc", "seek", "control", "getdev", "ptcreate", "ptjoin",
+    "ptlock", "ptunlock", "idle", "fork", "brk", "sbrk",
+]
+
+
+def finddump(data):
+    """Returns the header fields and the events of the last dump in data."""
+    magic = struct.pack("<I", KTRACE_MAGIC)
+    at = data.rfind(magic)
+    while at >= 0:
+        if len(data) - at >= HEADER.size:
+            hdr = HEADER.unpack_from(data, at)
+            if hdr[1] == KTRACE_VERSION:
+                start = at + HEADER.size
+                count = min(hdr[2], (len(data) - start) // EVENT.size)
+                events = [EVENT.unpack_from(data, start + i * EVENT.size)
+                          for i in range(count)]
+                return hdr, events
+        at = data.rfind(magic, 0, at)
+    sys.exit("ktrace2json: no trace dump found")
+
+
+def runslice(pid, start, end):
+    """A slice on the hart track for a process that ran from start to end."""
+    return {"name": "pid %d" % pid, "ph": "X", "pid": 1, "tid": 0,
+            "ts": start, "dur": end - start}
+
+
+def convert(hdr, events):
+    (_, _, count, lost, clkfreq, cycles0, time0, cycles1, time1) = hdr
+    if len(events) < count:
+        print("ktrace2json: dump cut short, %d of %d events"
+              % (len(events), count), file=sys.stderr)
+    if lost:
+        print("ktrace2json: %d older events were overwritten" % lost,
+              file=sys.stderr)
+
+    # The cycle rate, from the time CSR over the same stretch
+    if time1 > time0 and cycles1 > cycles0:
+        mhz = (cycles1 - cycles0) * clkfreq / (time1 - time0) / 1e6
+    else:
+        mhz = 1000.0
+    base = events[0][0] if events else 0
+
+    def us(cycles):
+        return (cycles - base) / mhz
+
+    out = []
+    running, since = None, None
+    for (cycles, id, pid, arg0, arg1) in events:
+        ts = us(cycles)
+        name = NAMES.get(id, "event %d" % id)
+        if id == KT_CTXSW:
+            if since is not None:
+                out.append(runslice(running, since, ts))
+            running, since = arg1, ts
+            out.append({"name": name, "ph": "i", "s": "t", "pid": 0,
+                        "tid": pid, "ts": ts, "args": {"to": arg1}})
+        elif id in (KT_SYSCALL, KT_SYSRET):
+            call = SYSCALLS[arg0] if arg0 < len(SYSCALLS) else str(arg0)
+            ev = {"name": "sys_" + call, "ph": "B" if id == KT_SYSCALL
+                  else "E", "pid": 0, "tid": pid, "ts": ts}
+            if id == KT_SYSRET:
+                ev["args"] = {"result": arg1 - (1 << 64)
+                              if arg1 >= 1 << 63 else arg1}
+            out.append(ev)
+        else:
+            out.append({"name": name, "ph": "i", "s": "t", "pid": 0,
+                        "tid": pid, "ts": ts,
+                        "args": {"arg0": hex(arg0), "arg1": hex(arg1)}})
+    if since is not None:
+        out.append(runslice(running, since, us(events[-1][0])))
+
+    tids = sorted({e["tid"] for e in out if e["pid"] == 0})
+    meta = [{"name": "process_name", "ph": "M", "pid": 0,
+             "args": {"name": "xinu"}},
+            {"name": "process_name", "ph": "M", "pid": 1,
+             "args": {"name": "hart 0"}}]
+    meta += [{"name": "thread_name", "ph": "M", "pid": 0, "tid": t,
+              "args": {"name": "pid %d" % t}} for t in tids]
+    return {"traceEvents": meta + out, "displayTimeUnit": "ns",
+            "otherData": {"cpu_mhz": round(mhz, 3), "lost": lost}}
+
+
+def main():
+    if len(sys.argv) != 2:
+        sys.exit("usage: ktrace2json.py console-capture > trace.json")
+    with open(sys.argv[1], "rb") as f:
+        data = f.read()
+    json.dump(convert(*finddump(data)), sys.stdout, indent=1)
+    print()
+
+
+if __name__ == "__main__":
+    main()
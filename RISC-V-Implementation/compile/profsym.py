@@ -0,0 +1,145 @@
+#!/usr/bin/env python3
+#
+# Symbolizes a profiler dump (see include/profile.h and profdump())
+# against the kernel image and prints a flat profile and one for each
+# process.
+#
+#   profsym.py xinu.elf console.log [top]
+#
+# The input is a raw capture of the console; the dump is found by its
+# magic number, so text printed around it does no harm.  User processes
+# run code from the kernel image, so one symbol table covers both modes.
+# Only the top functions of each table are shown, 20 unless given.
+#
+
+import bisect
+import collections
+import struct
+import sys
+
+PROF_MAGIC = 0x46525058
+PROF_VERSION = 1
+
+HEADER = struct.Struct("<IIIIQII")
+SAMPLE = struct.Struct("<QII")
+
+STT_NOTYPE, STT_FUNC = 0, 2
+
+
+class Symbols:
+    """The code symbols of an ELF64 little-endian image, by address."""
+
+    def __init__(self, path):
+        with open(path, "rb") as f:
+            elf = f.read()
+        if elf[:4] != b"\x7fELF" or elf[4] != 2 or elf[5] != 1:
+            sys.exit("profsym: %s is not a 64-bit little-endian ELF" % path)
+        (shoff,) = struct.unpack_from("<Q", elf, 0x28)
+        (shentsize, shnum) = struct.unpack_from("<HH", elf, 0x3A)
+        sections = [struct.unpack_from("<IIQQQQIIQQ", elf,
+                                       shoff + i * shentsize)
+                    for i in range(shnum)]
+
+        syms = {}
+        for (_, type, _, _, off, size, link, _, _, entsize) in sections:
+            if type != 2:               # SHT_SYMTAB
+                continue
+            stroff = sections[link][4]
+            for at in range(off, off + size, entsize):
+                (name, info, _, shndx, value, symsize) = \
+                    struct.unpack_from("<IBBHQQ", elf, at)
+                if shndx == 0 or value == 0 or \
+                        info & 0xF not in (STT_NOTYPE, STT_FUNC):
+                    continue
+                end = elf.index(b"\0", stroff + name)
+                label = elf[stroff + name:end].decode(errors="replace")
+                # Skip local labels and the RISC-V mapping symbols
+                if not label or label.startswith((".L", "$")):
+                    continue
+                # Where a function and a label share an address, keep the
+                # function
+                if value not in syms or info & 0xF == STT_FUNC:
+                    syms[value] = label
+        self.addrs = sorted(syms)
+        self.names = [syms[a] for a in self.addrs]
+
+    def lookup(self, pc):
+        i = bisect.bisect_right(self.addrs, pc) - 1
+        if i < 0:
+            return "0x%x" % pc
+        return self.names[i]
+
+
+def finddump(data):
+    """Returns the header fields, samples and process names of the last
+    dump in data."""
+    magic = struct.pack("<I", PROF_MAGIC)
+    at = data.rfind(magic)
+    while at >= 0:
+        if len(data) - at >= HEADER.size:
+            hdr = HEADER.unpack_from(data, at)
+            if hdr[1] == PROF_VERSION:
+                start = at + HEADER.size
+                count = min(hdr[2], (len(data) - start) // SAMPLE.size)
+                samples = [SAMPLE.unpack_from(data, start + i * SAMPLE.size)
+                           for i in range(count)]
+                names = {}
+                start += hdr[2] * SAMPLE.size
+                for pid in range(hdr[5]):
+                    raw = data[start + pid * hdr[6]:start + (pid + 1) * hdr[6]]
+                    name = raw.split(b"\0")[0].decode(errors="replace")
+                    if name:
+                        names[pid] = name
+                return hdr, samples, names
+        at = data.rfind(magic, 0, at)
+    sys.exit("profsym: no profile dump found")
+
+
+def table(title, counts, total, top):
+    """Prints the top entries of a Counter of (function, mode) pairs."""
+    print(title)
+    print("  samples      %  mode  function")
+    for ((func, kernel), n) in counts.most_common(top):
+        print("%9d %6.2f  %-4s  %s" % (n, 100.0 * n / total,
+                                       "kern" if kernel else "user", func))
+    print()
+
+
+def main():
+    if len(sys.argv) not in (3, 4):
+        sys.exit("usage: profsym.py xinu.elf console-capture [top]")
+    top = int(sys.argv[3]) if len(sys.argv) == 4 else 20
+    syms = Symbols(sys.argv[1])
+    with open(sys.argv[2], "rb") as f:
+        (hdr, samples, names) = finddump(f.read())
+    (_, _, count, dropped, period, _, _) = hdr
+    if len(samples) < count:
+        print("profsym: dump cut short, %d of %d samples"
+              % (len(samples), count), file=sys.stderr)
+    if not samples:
+        sys.exit("profsym: no samples")
+
+    flat = collections.Counter()
+    byproc = collections.defaultdict(collections.Counter)
+    kernel = 0
+    for (pc, pid, mode) in samples:
+        key = (syms.lookup(pc), mode)
+        flat[key] += 1
+        byproc[pid][key] += 1
+        kernel += mode
+
+    total = len(samples)
+    print("%d samples every %d us, %d dropped; %.1f%% kernel, %.1f%% user"
+          % (total, period, dropped, 100.0 * kernel / total,
+             100.0 * (total - kernel) / total))
+    print()
+    table("Flat profile", flat, total, top)
+    for pid in sorted(byproc, key=lambda p: -sum(byproc[p].values())):
+        n = sum(byproc[pid].values())
+        table("pid %d (%s): %d samples, %.1f%%"
+              % (pid, names.get(pid, "exited"), n, 100.0 * n / total),
+              byproc[pid], n, top)
+
+
+if __name__ == "__main__":
+    main()
@@ -9,5 +9,6 @@
 #include <stddef.h>
 
 #define IRQ_TIMER 75
+#define IRQ_UART0 18
 
 #endif                          /* _ALLWINNERD1_H_ */
@@ -0,0 +1,49 @@
+/**
+ * @file cache.h
+ * Data cache control on the C906 (Nezha).  Built with the D-cache on
+ * while DCACHE is nonzero, which is the default; DETAIL=-DDCACHE=0 boots
+ * with it off, as before.  Included by start.S.
+ */
+/* Embedded Xinu, Copyright (C) 2024.  All rights reserved. */
+
+#ifndef _CACHE_H_
+#define _CACHE_H_
+
+#ifndef DCACHE
+#define DCACHE 1
+#endif
+
+#define DCACHE_LINE     64              /* bytes per D-cache line        */
+
+/* T-Head machine-mode CSRs */
+#define CSR_MXSTATUS    0x7C0
+#define CSR_MHCR        0x7C1
+
+#define MXSTATUS_MAEE       (1 << 21)   /* memory types in PTE bits 63-59 */
+#define MXSTATUS_THEADISAEE (1 << 22)   /* cache and sync instructions    */
+
+#define MHCR_IE         (1 << 0)        /* instruction cache             */
+#define MHCR_DE         (1 << 1)        /* data cache                    */
+#define MHCR_WA         (1 << 2)        /* allocate a line on a write    */
+#define MHCR_WB         (1 << 3)        /* write back, not through       */
+#define MHCR_WBR        (1 << 8)        /* burst writes                  */
+
+#if DCACHE
+#define MHCR_BOOT       (MHCR_IE | MHCR_DE | MHCR_WA | MHCR_WB | MHCR_WBR)
+#else
+#define MHCR_BOOT       (MHCR_IE | MHCR_WB | MHCR_WBR)
+#endif
+
+/* T-Head instructions, for an assembler that does not know them */
+#define DCACHE_CIALL    .long 0x0030000b    /* clean and invalidate all  */
+#define SYNC_S          .long 0x0190000b    /* wait for cache operations */
+
+#ifndef __ASSEMBLER__
+
+void dcache_clean(const void *addr, ulong len);
+void dcache_inval(void *addr, ulong len);
+void dcache_flush(const void *addr, ulong len);
+
+#endif                          /* __ASSEMBLER__ */
+
+#endif                          /* _CACHE_H_ */
@@ -8,6 +8,7 @@
 #define _CLOCK_H_
 
 #include <stddef.h>
+#include <hart.h>
 
 /**
  * @ingroup timer
@@ -33,9 +34,68 @@ extern volatile ulong preempt;
  */
 extern volatile ulong clkticks;
 extern volatile ulong clktime;
+extern volatile ulong clkmaxlat;
+extern volatile ulong clkdeadline;
+
+/**
+ * @ingroup timer
+ *
+ * Constants for turning time counts into nanoseconds, worked out once by
+ * clkinit() so that clk_ns() needs no division.  The page holding them is
+ * mapped read-only at ::CLKPAGEADDR in the kernel and in every user
+ * process, so the same clk_ns() works in both.
+ */
+struct clkpage
+{
+    ulong freq;                 /**< time counts per second               */
+    ulong boot;                 /**< time count when clkinit() ran        */
+    ulong nsmult;               /**< ns = counts * nsmult >> CLK_NSSHIFT  */
+};
+
+#define CLK_NSSHIFT 32
+
+/** The clock page as clkinit() writes it */
+extern struct clkpage *const clkpage;
+
+/** The clock page as everything else reads it */
+#define CLKPAGE ((const volatile struct clkpage *)CLKPAGEADDR)
+
+/**
+ * @ingroup timer
+ * @return nanoseconds in a number of time counts
+ */
+static inline ulong clk_tons(ulong counts)
+{
+    return (ulong)(((unsigned __int128)counts * CLKPAGE->nsmult)
+                   >> CLK_NSSHIFT);
+}
+
+/**
+ * @ingroup timer
+ * @return nanoseconds since clkinit(), from the time CSR.  Never goes
+ *         backwards, and 0 until clkinit() has run.
+ */
+static inline ulong clk_ns(void)
+{
+    return clk_tons(rdtime() - CLKPAGE->boot);
+}
+
+/**
+ * @ingroup timer
+ * @return cycles of this hart, for timing short stretches of code
+ */
+static inline ulong clk_cycles(void)
+{
+    return rdcycle();
+}
+
+struct ktimer;
 
 /* Clock function prototypes. */
 void clkinit(void);
+void clkarm(ulong when);
 interrupt clkhandler(void);
+interrupt clkexpire(void);
+void clktick(struct ktimer *t, void *arg);
 
 #endif                          /* _CLOCK_H_ */
@@ -5,4 +5,20 @@ extern unsigned int gethartid(void);
 extern unsigned long getmisa(void);
 extern void set_satp(unsigned long);
 
+/** Read the free-running cycle counter of this hart */
+static inline unsigned long rdcycle(void)
+{
+    unsigned long cycles;
+    asm volatile ("rdcycle %0":"=r" (cycles));
+    return cycles;
+}
+
+/** Read the time counter, which runs at platform.clkfreq */
+static inline unsigned long rdtime(void)
+{
+    unsigned long time;
+    asm volatile ("rdtime %0":"=r" (time));
+    return time;
+}
+
 #endif                          /* _HART_H_ */
@@ -7,6 +7,17 @@
 typedef interrupt (*interrupt_handler_t)(void);
 
 extern interrupt_handler_t interruptVector[];
+extern interrupt_handler_t timerhandler;    /**< supervisor timer handler    */
+extern interrupt_handler_t softhandler;     /**< supervisor software handler */
+
+/* Bottom halves, run by the supervisor software interrupt */
+#define SOFTIRQ_CLOCK   0       /**< kernel timer expiry                 */
+#define SOFTIRQ_UART    1       /**< wake processes reading the console  */
+#define NSOFTIRQ        4
+
+extern interrupt_handler_t softvector[];
+extern volatile ulong softpending;  /**< bottom halves raised, by bit    */
+extern volatile bool needresched;   /**< resched() once they have run   */
 
 typedef unsigned long irqmask;  /**< machine status for disable/restore  */
 
@@ -46,12 +57,83 @@ void disable_irq(irqmask);
 ulong dispatch(ulong cause, ulong val, ulong *frame,
               ulong *program_counter);
 void xtrap(ulong *frame, ulong cause, ulong address, ulong *pc);
+void extintr(ulong *trace);
+void timerintr(ulong *trace);
+void softintr(ulong *trace);
+void softraise(uint n);
+extern char trapvec[];
+extern char *trap_names[];
+
+static inline ulong get_sepc(void)
+{
+    ulong x;
+
+    asm volatile ("csrr %0, sepc":"=r" (x));
+    return x;
+}
 
 static inline void set_sepc(ulong x)
 {
     asm volatile ("csrw sepc, %0"::"r" (x));
 }
 
+/** sscratch holds the swap area in user mode and zero in the kernel */
+static inline void set_sscratch(ulong x)
+{
+    asm volatile ("csrw sscratch, %0"::"r" (x));
+}
+
+static inline ulong get_sstatus(void)
+{
+    ulong x;
+
+    asm volatile ("csrr %0, sstatus":"=r" (x));
+    return x;
+}
+
+/** Sets the given sstatus bits, leaving the others alone */
+static inline void sstatus_set(ulong bits)
+{
+    asm volatile ("csrs sstatus, %0"::"r" (bits));
+}
+
+/** Clears the given sstatus bits, leaving the others alone */
+static inline void sstatus_clear(ulong bits)
+{
+    asm volatile ("csrc sstatus, %0"::"r" (bits));
+}
+
+static inline ulong get_stvec(void)
+{
+    ulong x;
+
+    asm volatile ("csrr %0, stvec":"=r" (x));
+    return x;
+}
+
+static inline void set_stvec(ulong x)
+{
+    asm volatile ("csrw stvec, %0"::"r" (x));
+}
+
+/** Clears the given sie bits, masking those interrupts */
+static inline void sie_clear(ulong bits)
+{
+    asm volatile ("csrc sie, %0"::"r" (bits));
+}
+
+/** Sets the given sip bits; only SSIP is writable */
+static inline void sip_set(ulong bits)
+{
+    asm volatile ("csrs sip, %0"::"r" (bits));
+}
+
+/** Clears the given sip bits */
+static inline void sip_clear(ulong bits)
+{
+    asm volatile ("csrc sip, %0"::"r" (bits));
+}
+
 #define PLIC_BASE       0x10000000      /* Platform-level Interrupt Controller */
 #define PLIC_SCLAIM_REG   0x201004      /* PLIC supervisor claim register      */
 #define PLIC_SIE_REGN	0x2080  /* Superuser mode interrupt enable */
@@ -0,0 +1,60 @@
+/**
+ * @file irqtrace.h
+ * Interrupt latency tracing.  Built in while IRQTRACE is nonzero; build
+ * with DETAIL=-DIRQTRACE=0 to leave it out.  Also included by assembly,
+ * so everything but the constants is kept from the assembler.
+ */
+/* Embedded Xinu, Copyright (C) 2024.  All rights reserved. */
+
+#ifndef _IRQTRACE_H_
+#define _IRQTRACE_H_
+
+#ifndef IRQTRACE
+#define IRQTRACE 1
+#endif
+
+/* Words interrupt.S keeps for each interrupt in its trap frame */
+#define IRQT_ENTRY 0            /**< cycle counter at trap entry          */
+#define IRQT_STAT 1             /**< irqstat charged on the way out, or 0 */
+#define IRQT_WORDS 2
+
+#define NIRQSTAT 8              /**< interrupt sources traced separately  */
+#define IRQHIST 24              /**< log2 buckets; the last one is open   */
+
+/* Sources that are not PLIC interrupt numbers */
+#define IRQ_STIMER  0x100       /**< supervisor timer (stimecmp)          */
+#define IRQ_SSOFT   0x101       /**< supervisor software interrupt        */
+#define IRQ_OTHER   0x1FF       /**< shared by sources past NIRQSTAT      */
+
+#ifndef __ASSEMBLER__
+
+/**
+ * Per-source statistics, in cycles.  Latency runs from trap entry to the
+ * handler being called, total from trap entry to the stub's way out.
+ */
+struct irqstat
+{
+    uint irq;                   /**< source, 0 if the slot is unused      */
+    ulong count;                /**< interrupts timed                     */
+    ulong switched;             /**< handler rescheduled; not timed       */
+    ulong latmin, latmax, lattotal;
+    ulong runmin, runmax, runtotal;
+    uint hist[IRQHIST];         /**< totals by floor(log2(cycles))        */
+};
+
+extern struct irqstat irqstats[];
+extern ulong irqswitches;       /* context switches, for irqrun()        */
+extern ulong irqoffstart;       /* cycle interrupts were last disabled   */
+extern ulong irqoffwhere;       /* and the caller of disable()           */
+extern ulong irqoffmax;         /* longest window with interrupts off    */
+extern ulong irqofffrom, irqoffto;  /* where it began and ended          */
+
+void irqrun(uint irq, interrupt_handler_t handler, ulong *trace);
+void irqtrace_exit(ulong *trace);
+void irqoffend(ulong pc);
+void irqtrace_reset(void);
+void irqstat(void);
+
+#endif                          /* __ASSEMBLER__ */
+
+#endif                          /* _IRQTRACE_H_ */
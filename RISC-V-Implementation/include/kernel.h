@@ -20,6 +20,7 @@ void nulluser(void);
 /* Kernel function prototypes */
 syscall kprintf(const char *fmt, ...);
 syscall kputc(uchar);
+syscall kwrite(const uchar *, uint);
 syscall kungetc(uchar);
 syscall kgetc(void);
 syscall kcheckc(void);
@@ -27,8 +28,13 @@ syscall kvprintf(const char *fmt, va_list va);
 
 syscall create(void *, ulong, uint, char *, ulong, ...);
 syscall kill(pid_typ);
+syscall forkproc(pid_typ);
+pid_typ newpid(void);
+syscall kstackinit(pid_typ);
 syscall ready(pid_typ, bool);
 syscall resched(void);
+void ctxsw(void **, void **);
+void userstart(void);
 
 extern void _start(void);
 
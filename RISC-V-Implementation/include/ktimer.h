@@ -0,0 +1,58 @@
+/**
+ * @file ktimer.h
+ * Kernel timers on a hierarchical timing wheel.
+ */
+/* Embedded Xinu, Copyright (C) 2024.  All rights reserved. */
+
+#ifndef _KTIMER_H_
+#define _KTIMER_H_
+
+#include <stddef.h>
+
+/*
+ * The wheel counts in granules of 2^TW_GRAN time counts (42.7 us at
+ * 24 MHz).  Each of TW_LEVELS levels has TW_SLOTS slots, level l holding
+ * the timers due in the current 64^(l+1) granule block but past its
+ * current 64^l granule block; together they reach 2^46 counts (about a
+ * month at 24 MHz), and anything later waits on a separate list.  A timer
+ * fires at its exact deadline, not at the end of its granule.
+ */
+#define TW_GRAN     10
+#define TW_BITS     6
+#define TW_SLOTS    (1 << TW_BITS)
+#define TW_MASK     (TW_SLOTS - 1)
+#define TW_LEVELS   6
+#define TW_FAR      (TW_LEVELS * TW_SLOTS)  /**< slot of the far list     */
+#define TW_NEVER    (~0UL)                   /**< no deadline              */
+
+struct ktimer;
+
+/** Called with interrupts off when a timer expires; must not resched() */
+typedef void (*ktimerfn)(struct ktimer *, void *);
+
+/**
+ * A kernel timer.  The owner keeps the memory; ktimer_init() it once,
+ * then arm and cancel it as often as needed.
+ */
+struct ktimer
+{
+    struct ktimer *next;        /**< next timer in the same slot          */
+    struct ktimer **pprev;      /**< link that points here, NULL if idle  */
+    ulong when;                 /**< deadline in time counts              */
+    ulong period;               /**< time counts between firings, or 0    */
+    uint slot;                  /**< level * TW_SLOTS + slot, or TW_FAR   */
+    ktimerfn func;              /**< called at the deadline               */
+    void *arg;                  /**< second argument to func              */
+};
+
+/** @return TRUE if the timer is armed */
+#define ktimer_pending(t)   ((t)->pprev != NULL)
+
+void ktimerinit(void);
+void ktimer_init(struct ktimer *t, ktimerfn func, void *arg);
+syscall ktimer_arm(struct ktimer *t, ulong delay, ulong period);
+syscall ktimer_cancel(struct ktimer *t);
+void ktimer_expire(void);
+void ktimerstat(void);
+
+#endif                          /* _KTIMER_H_ */
@@ -0,0 +1,87 @@
+/**
+ * @file ktrace.h
+ * Kernel trace buffer.  Built in while KTRACE is nonzero; build with
+ * DETAIL=-DKTRACE=0 to leave every tracepoint out.  compile/ktrace2json.py
+ * turns a ktracedump() into Chrome/Perfetto trace JSON, and its table of
+ * event names must follow the IDs here.
+ */
+/* Embedded Xinu, Copyright (C) 2024.  All rights reserved. */
+
+#ifndef _KTRACE_H_
+#define _KTRACE_H_
+
+#include <stddef.h>
+#include <clock.h>
+
+#ifndef KTRACE
+#define KTRACE 1
+#endif
+
+#define KTRACE_LEN  4096        /**< events kept, a power of two          */
+#define KTRACE_MAGIC 0x52544B58 /**< "XKTR" at the start of a dump        */
+#define KTRACE_VERSION 1
+
+/* Event IDs; arguments in brackets */
+#define KT_RESCHED  1           /**< resched() [old pid, new pid]         */
+#define KT_CTXSW    2           /**< ctxsw() is called [old pid, new pid] */
+#define KT_TRAP     3           /**< dispatch() [scause, stval]           */
+#define KT_IRQ      4           /**< extintr() claim [irq, 0]             */
+#define KT_SYSCALL  5           /**< system call starts [number, pid]     */
+#define KT_SYSRET   6           /**< system call returns [number, result] */
+#define KT_PGALLOC  7           /**< frames allocated [address, order]    */
+#define KT_CLOCK    8           /**< clkhandler() [counts late, 0]        */
+#define KT_USER     9           /**< free for experiments [any, any]      */
+
+/** One event; a dump sends these as they are, little-endian */
+struct ktevent
+{
+    ulong cycles;               /**< clk_cycles() when it was recorded    */
+    uint id;                    /**< KT_* event                           */
+    uint pid;                   /**< currpid                              */
+    ulong arg[2];
+};
+
+/** Precedes the events of a dump */
+struct ktheader
+{
+    uint magic;                 /**< KTRACE_MAGIC                         */
+    uint version;               /**< KTRACE_VERSION                       */
+    uint count;                 /**< events that follow, oldest first     */
+    uint lost;                  /**< older events overwritten             */
+    ulong clkfreq;              /**< time counts per second               */
+    ulong cycles0, time0;       /**< cycles and time at ktrace_reset()    */
+    ulong cycles1, time1;       /**< and at the dump, for the cycle rate  */
+};
+
+#if KTRACE
+extern struct ktevent ktracebuf[];
+extern ulong ktraceidx;
+extern bool ktraceon;
+
+/**
+ * Records an event.  The slot is claimed with one atomic add, so a
+ * tracepoint needs no lock and may be hit again by an interrupt
+ * while it is filling its slot.
+ */
+static inline void ktrace(uint id, ulong arg0, ulong arg1)
+{
+    struct ktevent *ev;
+
+    if (!ktraceon)
+        return;
+    ev = &ktracebuf[__atomic_fetch_add(&ktraceidx, 1, __ATOMIC_RELAXED)
+                    & (KTRACE_LEN - 1)];
+    ev->cycles = clk_cycles();
+    ev->id = id;
+    ev->pid = currpid;
+    ev->arg[0] = arg0;
+    ev->arg[1] = arg1;
+}
+#else
+#define ktrace(id, arg0, arg1)
+#endif
+
+void ktrace_reset(void);
+void ktracedump(void);
+
+#endif                          /* _KTRACE_H_ */
@@ -21,6 +21,70 @@ extern void *_ctxswe;           /* end of ctxsw                       */
 extern void *_interrupts;       /* start of interrupts                */
 extern void *_interrupte;       /* end of interrupts                  */
 extern ulong *_kernpgtbl;	/* kernel page table                  */
-extern ulong *_kernsp;          /* kernel stack pointer               */
+extern ulong *_userpgtbl;       /* root shared by user page tables    */
+
+/* Kernel object caches */
+
+#define NKMCACHE     16         /**< maximum number of object caches    */
+#define KMC_NAMELEN  16         /**< length of a cache name             */
+#define KMC_PAGE     0x1        /**< objects are whole frames           */
+#define KMC_PGTBL    0x2        /**< frames hold page tables            */
+
+/** Bytes at the start of each slab page used by struct kmslab */
+#define KMSLAB_HDR   64
+
+/** Smallest and largest kmalloc() size class; larger requests get pages */
+#define KM_MINCLASS  16
+#define KM_MAXCLASS  1024
+
+/**
+ * Header at the start of every slab page.  Free objects in the slab are
+ * chained through their first word.  A large kmalloc() block carries the
+ * same header with a NULL cache and its block order in inuse.
+ */
+struct kmslab
+{
+    struct kmslab *next;        /**< next slab with free objects        */
+    struct kmslab *prev;        /**< previous slab with free objects    */
+    struct kmcache *cache;      /**< cache this slab belongs to         */
+    void *freelist;             /**< first free object in this slab     */
+    uint inuse;                 /**< objects handed out from this slab  */
+};
+
+/**
+ * A cache of fixed-size kernel objects.
+ */
+struct kmcache
+{
+    char name[KMC_NAMELEN];     /**< name shown by kmstat()             */
+    ulong objsize;              /**< object stride in bytes             */
+    uint perslab;               /**< objects that fit in one slab       */
+    uint flags;                 /**< KMC_* flags                        */
+    struct kmslab *partial;     /**< slabs with at least one free object */
+    uint nslabs;                /**< slab pages owned by the cache      */
+    uint nempty;                /**< slabs with no objects in use       */
+    ulong inuse;                /**< objects currently allocated        */
+    ulong peak;                 /**< most objects ever allocated        */
+    ulong nalloc;               /**< successful allocations             */
+    ulong nfree;                /**< frees                              */
+    ulong nfail;                /**< failed allocations                 */
+};
+
+extern struct kmcache kmcachetab[];
+extern struct kmcache *swapcache;       /* per-process swap areas      */
+extern struct kmcache *pgtblcache;      /* page table pages            */
+
+void kminit(void);
+struct kmcache *kmcache_create(const char *name, ulong size, ulong align,
+                               uint flags);
+void *kmcache_alloc(struct kmcache *cache);
+syscall kmcache_free(struct kmcache *cache, void *obj);
+void *kmalloc(ulong size);
+syscall kfree(void *ptr);
+void kmstat(void);
+
+/* User-mode heap allocator, grows through user_sbrk() */
+void *umalloc(ulong size);
+void ufree(void *ptr);
 
 #endif                          /* _MEMORY_H_ */
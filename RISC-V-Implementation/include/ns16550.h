@@ -11,6 +11,11 @@
 #include <stddef.h>
 
 #define UART_BASE  0x2500000L
+#define UART_USR   0x7C         /**< offset of the UART status register */
+#define UART_FIFO_LEN 64        /**< bytes in each hardware FIFO        */
+
+#define UART_TXBUF 4096         /**< bytes queued for the transmitter   */
+#define UART_RXBUF 256          /**< bytes received and not yet read    */
 
 /**
  * Control and status registers for the 16550 UART.  This structure is
@@ -47,6 +52,16 @@ struct ns16550_uart_csreg
 #define UART_IER_INT_EN	(1<<4)	/**< RS485 interrupt enable             */
 #define UART_IER_PTIME	(1<<7)	/**< Programmable THRE interrupt enable */
 
+/* Interrupt identification values, in the low four bits              */
+#define UART_IIR_IDMASK	0x0F	/**< Mask for the interrupt ID          */
+#define UART_IIR_MSI	0x00	/**< Modem status                       */
+#define UART_IIR_NOINT	0x01	/**< No interrupt pending               */
+#define UART_IIR_THRE	0x02	/**< Transmit-hold-register empty       */
+#define UART_IIR_RDA	0x04	/**< Received data available            */
+#define UART_IIR_RLSI	0x06	/**< Receiver line status               */
+#define UART_IIR_BUSY	0x07	/**< Busy detect; read UART_USR to clear */
+#define UART_IIR_RTO	0x0C	/**< Receiver timeout                   */
+
 /* FIFO control bits */
 #define UART_FCR_FIFOE	(1<<0)	/**< Enable in and out hardware FIFOs   */
 #define UART_FCR_RFIFOR	(1<<1)	/**< Reset receiver FIFO                */
@@ -90,4 +105,17 @@ struct ns16550_uart_csreg
 #define UART_MSR_RI	(1<<6)	/**< Line state of ring indicator       */
 #define UART_MSR_DCD	(1<<7)	/**< Line state of data carrier detect  */
 
+/* Interrupt-driven console driver */
+extern ulong uartlsrreads;      /**< line status reads while polling    */
+
+void uartinit(void);
+interrupt uartintr(void);
+interrupt uartwake(void);
+syscall uartputc(uchar c);
+syscall uartwrite(const uchar *buf, uint len);
+syscall uartgetc(void);
+bool uartcanread(void);
+void uartpoll(bool on);
+void uartstat(void);
+
 #endif                          /* _NS16550_H_ */
@@ -27,6 +27,7 @@
 #define PRCURR      1       /**< process is currently running            */
 #define PRSUSP      2       /**< process is suspended                    */
 #define PRREADY     3       /**< process is on ready queue               */
+#define PRWAIT      4       /**< process is waiting on a device queue    */
 
 /* miscellaneous process definitions                                     */
 
@@ -53,11 +54,17 @@ typedef struct pentry
     int state;           /**< process state: PRCURR, etc.             */
     void *stkbase;       /**< base of run time stack                  */
     int stklen;          /**< stack length                            */
-    void *stkptr;        /**< base of run time stack                  */
+    void *stkptr;        /**< kernel sp saved by ctxsw()              */
+    void *kstack;        /**< kernel stack page, KSTACKSIZE bytes     */
     char name[PNMLEN];   /**< process name                            */
     ulong tickets;       /**< priority in lottery scheduler           */
     pgtbl pagetable;     /**< process page table                      */
     ulong *swaparea;     /**< per-process swap area                   */
+    struct vma vma[NVMA]; /**< stack and heap regions                 */
+    ulong minflt;        /**< page faults that only changed a mapping */
+    ulong majflt;        /**< page faults that had to fill a frame    */
+    ulong fpregs[FPCONTEXT]; /**< f0-f31 and fcsr, as last saved      */
+    ulong fptraps;       /**< times the FPU was turned back on        */
 } pcb;
 
 /* process initialization constants */
@@ -65,6 +72,7 @@ typedef struct pentry
 #define INITRET  userret    /**< processes return address             */
 #define MINSTK   4096       /**< minimum process stack size           */
 #define NULLSTK  MINSTK     /**< null process stack size              */
+#define KSTACKSIZE PAGE_SIZE /**< kernel stack of each user process   */
 
 /* Priority constants */
 #define PRIORITY_LOW	1   /**< low process priority                 */
@@ -74,5 +82,14 @@ typedef struct pentry
 extern struct pentry proctab[];
 extern int numproc;         /**< currently active processes           */
 extern int currpid;         /**< currently executing process          */
+extern int fpowner;         /**< process whose state is in the FPU    */
+extern void *deadkstack;    /**< kernel stack of a suicide, to free   */
+
+/* Lazy floating-point context, see fpu.c */
+void fpuswitch(pcb *oldproc);
+void fpuflush(void);
+syscall fputrap(void);
+void fpusave(ulong *fpregs);
+void fpurestore(ulong *fpregs);
 
 #endif                          /* _PROC_H_ */
@@ -0,0 +1,68 @@
+/**
+ * @file profile.h
+ * PC-sampling profiler.  Built in while PROFILE is nonzero; build with
+ * DETAIL=-DPROFILE=0 to take it out of the clock interrupt altogether.
+ * compile/profsym.py turns a profdump() into flat and per-process
+ * profiles against xinu.elf.
+ */
+/* Embedded Xinu, Copyright (C) 2024.  All rights reserved. */
+
+#ifndef _PROFILE_H_
+#define _PROFILE_H_
+
+#include <stddef.h>
+#include <ktimer.h>
+
+#ifndef PROFILE
+#define PROFILE 1
+#endif
+
+#define PROF_LEN     16384      /**< samples kept; later ones are dropped */
+#define PROF_MAGIC   0x46525058 /**< "XPRF" at the start of a dump        */
+#define PROF_VERSION 1
+
+/** One sample; a dump sends these as they are, little-endian */
+struct profsample
+{
+    ulong pc;                   /**< sepc at the clock interrupt          */
+    uint pid;                   /**< currpid                              */
+    uint kernel;                /**< 1 if taken in S-mode, 0 in U-mode    */
+};
+
+/** Precedes the samples of a dump; a table of NPROC names follows them */
+struct profheader
+{
+    uint magic;                 /**< PROF_MAGIC                           */
+    uint version;               /**< PROF_VERSION                         */
+    uint count;                 /**< samples that follow                  */
+    uint dropped;               /**< samples lost to a full buffer        */
+    ulong period;               /**< microseconds between samples         */
+    uint nproc;                 /**< names in the table                   */
+    uint pnmlen;                /**< bytes per name                       */
+};
+
+#if PROFILE
+extern bool profon;
+extern struct ktimer proftimer;
+
+void profsample(void);
+
+/**
+ * Called by the clock interrupt.  Takes a sample when the profiling
+ * timer is what made the clock go off, so other timers do not skew the
+ * rate; the timer itself does nothing but keep the clock coming.
+ */
+static inline void profclock(ulong now)
+{
+    if (profon && now >= proftimer.when)
+        profsample();
+}
+#else
+#define profclock(now)
+#endif
+
+syscall profstart(ulong period);
+void profstop(void);
+void profdump(void);
+
+#endif                          /* _PROFILE_H_ */
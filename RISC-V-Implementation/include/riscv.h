@@ -22,6 +22,16 @@
 #define RISCV_SIE_SSIE (1<<1)
 
 #define RISCV_ENABLE_ALL_SMODE_INTR (RISCV_SIE_SEIE | RISCV_SIE_STIE | RISCV_SIE_SSIE)
+#define RISCV_SIP_SSIP (1<<1)      /* supervisor software interrupt pending */
+
+#define STVEC_MODE          3      /* low bits of stvec                     */
+#define STVEC_MODE_DIRECT   0      /* every trap enters at the base         */
+#define STVEC_MODE_VECTORED 1      /* interrupt n enters at base + 4*n      */
+#define RISCV_COUNTEREN_CY (1<<0)  /* cycle counter readable by lower modes   */
+#define RISCV_COUNTEREN_TM (1<<1)  /* time counter readable by lower modes    */
+#define RISCV_COUNTEREN_IR (1<<2)  /* instret counter readable by lower modes */
+#define MENVCFG_STCE (1UL<<63)     /* stimecmp usable in S-mode (Sstc)       */
+
 #define RISCV_MAX_ADDR 0x3FFFFFFFFFFFFFull
 #define RISCV_ALL_PERM 0xF
 
@@ -29,12 +39,21 @@
 #define INTERRUPTADDR	0x3FFFFFF000    // truncpage((MAXVIRTADDR - PAGE_SIZE))
 #define SWAPAREAADDR	0x3FFFFFE000    // truncpage((MAXVIRTADDR - PAGE_SIZE))
 #define PROCSTACKADDR	0x3FFFFFD000    // truncpage((MAXVIRTADDR - PAGE_SIZE - PAGE_SIZE))
+#define USERHEAPADDR	0x1000000000    // base of the user heap, one root entry of its own
+#define CLKPAGEADDR	0x0FFFFFF000    // clock page, read-only in every address space
+#define USERHEAPMAX	0x40000000      // largest user heap, 1 GiB
 
 #define WATCHDOG_CONF   0x00020500B4
 
 #define SSTATUS_S_MODE  (1L<<8)
 #define SSTATUS_U_MODE  0x0
 #define SSTATUS_PRIV_MODE_BIT   (1L<<8)
+#define SSTATUS_SIE       (1<<1)    /* interrupts taken in S-mode           */
+#define SSTATUS_SPIE      (1<<5)    /* SIE before the trap                  */
+#define SSTATUS_FS        (3L<<13)  /* floating-point unit state            */
+#define SSTATUS_FS_OFF    (0L<<13)  /* F and D instructions trap            */
+#define SSTATUS_FS_CLEAN  (2L<<13)  /* FP registers match the saved copy    */
+#define SSTATUS_FS_DIRTY  (3L<<13)  /* FP registers written since then      */
 
 #define CONTEXT   36            /**< context record size in words         */
 #define ARG_REG_MAX 8
@@ -75,5 +94,55 @@
 
 #define CTX_KERNSATP 32
 #define CTX_KERNSP 33
+#define CTX_IRQCYCLE 34         /**< entry cycle of an interrupt, IRQTRACE */
+
+/* Frame ctxsw() leaves on a kernel stack: what a C call must preserve */
+#define CTXSW_RA 0
+#define CTXSW_S0 1
+#define CTXSW_S1 2
+#define CTXSW_S2 3
+#define CTXSW_S3 4
+#define CTXSW_S4 5
+#define CTXSW_S5 6
+#define CTXSW_S6 7
+#define CTXSW_S7 8
+#define CTXSW_S8 9
+#define CTXSW_S9 10
+#define CTXSW_S10 11
+#define CTXSW_S11 12
+#define CTXSW_TP 13
+#define CTXSW_FRAME 14          /**< words, a multiple of two for alignment */
+
+/* Frame interrupt.S pushes on the kernel stack for a trap taken in
+ * S-mode: the registers a C call may clobber, plus what sret needs */
+#define KTRAP_RA 0
+#define KTRAP_T0 1
+#define KTRAP_T1 2
+#define KTRAP_T2 3
+#define KTRAP_T3 4
+#define KTRAP_T4 5
+#define KTRAP_T5 6
+#define KTRAP_T6 7
+#define KTRAP_A0 8
+#define KTRAP_A1 9
+#define KTRAP_A2 10
+#define KTRAP_A3 11
+#define KTRAP_A4 12
+#define KTRAP_A5 13
+#define KTRAP_A6 14
+#define KTRAP_A7 15
+#define KTRAP_PC 16
+#define KTRAP_STATUS 17
+#define KTRAP_TRACE 18          /**< IRQT_WORDS for an interrupt, IRQTRACE  */
+#define KTRAP_FRAME 20          /**< words, a multiple of two for alignment */
+
+/* Frame for a trap from U-mode; the registers are in the swap area */
+#define UTRAP_SWAPAREA 0        /**< swap area address, as the process sees it */
+#define UTRAP_SATP 1            /**< satp to return to; interrupt stubs only */
+#define UTRAP_TRACE 2           /**< IRQT_WORDS for an interrupt, IRQTRACE  */
+#define UTRAP_FRAME 4
+
+#define FPCONTEXT 33            /**< f0-f31 and fcsr, in words            */
+#define FPCTX_FCSR 32
 
 #endif                          /* _RISCV_H_ */
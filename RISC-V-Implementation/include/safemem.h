@@ -20,19 +20,132 @@
 #define truncpage(x) ((ulong)(x) & ~0x0FFF)
 
 /**
- * Linked list struct for keeping track of free physical pages
+ * Largest block order handled by the buddy allocator.  A block of order n
+ * is 2^n physically contiguous pages, so the largest block is 4 MiB.
+ */
+#define PG_MAXORDER 10
+
+/** Marks a frame that is not the head of a free block in frame::order */
+#define PG_NOTFREE  0xFF
+
+/** Number of bytes in a block of the given order */
+#define PG_BLKSIZE(order)  ((ulong)PAGE_SIZE << (order))
+/** Index of a physical frame relative to the first managed frame */
+#define PG_INDEX(pa)       (((ulong)(pa) - pgbase) / PAGE_SIZE)
+/** True if the physical address is a frame managed by the allocator */
+#define PG_MANAGED(pa)     ((ulong)(pa) >= pgbase && (ulong)(pa) < pgend)
+/** Metadata of the frame holding a physical address */
+#define PG_FRAME(pa)       (&frametab[PG_INDEX(pa)])
+
+/* Frame flags */
+#define FR_FREE     0x01        /**< head of a block on a buddy free list  */
+#define FR_ZEROED   0x02        /**< cleared and waiting in the zero pool  */
+#define FR_KERNEL   0x04        /**< allocated for kernel use              */
+#define FR_USER     0x08        /**< mapped into a user address space      */
+#define FR_PGTBL    0x10        /**< holds a page table                    */
+#define FR_SLAB     0x20        /**< holds slab objects                    */
+
+/**
+ * Metadata kept for every managed physical frame, indexed by PG_INDEX().
+ * A block from pgalloc_order() is described by its first frame.
+ */
+struct frame
+{
+    ushort refcount;            /**< references; the allocation is one     */
+    ushort mapcount;            /**< user (PTE_U) mappings of the frame    */
+    uchar flags;                /**< FR_* flags                            */
+    uchar order;                /**< order of the free block, or PG_NOTFREE */
+    short owner;                /**< pid that owns the frame, or BADPID    */
+};
+
+/**
+ * Doubly linked list struct for keeping track of free physical blocks.
+ * It lives in the first bytes of the free block itself.
  */
 struct pgmemblk
 {
     struct pgmemblk *next;
+    struct pgmemblk *prev;
 };
 
-extern struct pgmemblk *pgfreelist;      /*      Linked list of physical free pages    */
+/**
+ * One free list per block order.
+ */
+struct pgfreearea
+{
+    struct pgmemblk *head;      /**< first free block of this order       */
+    uint nfree;                 /**< number of free blocks of this order  */
+};
+
+/** Most ranges of free memory that have not been carved into blocks */
+#define PG_NEXTENT 8
+
+/**
+ * A range of free physical memory that has not been handed to the buddy
+ * lists yet.  Neither its frames nor their frame table entries are
+ * touched until pgcarve() splits a block off the front.
+ */
+struct pgextent
+{
+    ulong base;                 /**< first free frame, page aligned       */
+    ulong end;                  /**< end of the range, page aligned       */
+};
+
+extern struct pgfreearea pgfreearea[];   /*      Buddy free lists, one per order       */
+extern struct pgextent pgextent[];       /*      Free memory not yet carved            */
+extern uint pgnextent;                   /*      Number of entries in pgextent         */
+extern struct frame *frametab;           /*      Metadata of each managed frame        */
+extern ulong pgbase;                     /*      First frame managed by the allocator  */
+extern ulong pgend;                      /*      End of the managed frames             */
 extern uint pgtbl_nents;                 /*      Number of pages in the entire system  */
 
+/** Most frames kept pre-zeroed for pgalloc() */
+#define PG_ZEROPOOL  64
+/** Frames zeroed by the null process on each idle pass */
+#define PG_ZEROBATCH 4
+
+extern struct pgmemblk *pgzerolist;      /*      Singly linked list of zeroed frames   */
+extern uint pgzerocount;                 /*      Number of frames on pgzerolist        */
+
+/**
+ * @return TRUE if a managed frame has been carved out of the free
+ *         extents, so its frame table entry means something
+ */
+static inline bool pgcarved(ulong pa)
+{
+    uint i;
+
+    for (i = 0; i < pgnextent; i++)
+    {
+        if (pa >= pgextent[i].base && pa < pgextent[i].end)
+            return FALSE;
+    }
+    return TRUE;
+}
+
 typedef ulong *pgtbl;
 typedef ulong *page;
 
+/**
+ * A range of user address space whose pages are made on demand.  The
+ * page fault path maps a zeroed frame with prot under any unmapped
+ * address inside it.
+ */
+struct vma
+{
+    ulong start;                /**< first address, page aligned          */
+    ulong end;                  /**< end of the range; the heap break     */
+    uint prot;                  /**< PTE_R, PTE_W, PTE_X of its pages     */
+    uint flags;                 /**< VMA_GROWSDOWN                        */
+};
+
+#define VMA_GROWSDOWN 0x1       /**< grows down on faults just below it   */
+
+/* Regions of every user process, indexes into pcb::vma */
+#define VMA_STACK   0
+#define VMA_HEAP    1
+#define NVMA        2
+
 /* SATP Register hold the Address Space Identifier (ASID) and the Physical Page Number (PPN)
 *  The ASID allows the TLB to detect if the address space has been switched.  In Embedded Xinu, the ASID is the process ID
 *  The PPN is the physical address of the root level page table divided by 4096 (PAGE_SIZE)
@@ -62,25 +175,84 @@ typedef ulong *page;
 #define PTE_G (1 << 5)    // Global bit indicates global mappings. Global mappings are those that exist in all address spaces
 #define PTE_A (1 << 6)    // Access bit indicates the virtual page has been read, written, or fetched from since the last time the A bit was cleared.
 #define PTE_D (1 << 7)    // Dirty bit indicates the virtual page has been writen to since the last time the dirty bit was cleared.
+#define PTE_COW (1 << 8)  // Software bit (RSW) marking a page made read-only by fork(); a store fault copies it
+
+#define PTE_PPN      (((1UL << 44) - 1) << 10)          // The physical page number, bits 53-10
 
-#define PTE2PA(pte)  ((pte >> 10) * PAGE_SIZE)          // Remove the first 10 bits (any attributes).  Then multiply it by 4096 (page size)
+/* Memory types of a leaf on the C906 (mxstatus.MAEE), in bits 63-59,
+ * which the standard leaves to extensions.  RAM is cached; devices are
+ * strongly ordered and bypass the cache.  Other platforms leave them 0. */
+#ifdef _XINU_PLATFORM_RISCV_NEZHA_
+#define PTE_SO    (1UL << 63)   // Strong order: no reordering or merging
+#define PTE_C     (1UL << 62)   // Cacheable
+#define PTE_B     (1UL << 61)   // Bufferable: writes may be posted
+#define PTE_SH    (1UL << 60)   // Shareable
+#define PTE_MEM   (PTE_C | PTE_B | PTE_SH)
+#define PTE_NC    (PTE_B | PTE_SH)
+#define PTE_IO    (PTE_SO | PTE_SH)
+#define DRAM_BASE 0x40000000UL  // Physical addresses below are devices
+#else
+#define PTE_MEM   0UL
+#define PTE_NC    0UL
+#define PTE_IO    0UL
+#define DRAM_BASE 0x80000000UL
+#endif
+#define PTE_MEMTYPE (0x1FUL << 59)
+
+#define PTE2PA(pte)  ((((pte) & PTE_PPN) >> 10) * PAGE_SIZE) // Keep only the page number.  Then multiply it by 4096 (page size)
 #define PA2PTE(pa)   (((ulong)pa / PAGE_SIZE) << 10)    // Opposite of PTE2PA. Divide by the page size and then make room for flags
+#define PTE_LEAF     (PTE_R | PTE_W | PTE_X)            // Any of these bits set means the entry maps memory rather than a table
+#define PTE_PER_TBL  (PAGE_SIZE / sizeof(ulong))        // Entries in one page table
+
+/** Address of a swap area as seen through the SWAPAREAADDR mapping */
+#define SWAPAREAVA(sa) (SWAPAREAADDR + ((ulong)(sa) & (PAGE_SIZE - 1)))
 
 /* Prototypes for dealing with physical pages */
 void pgInit(void);
 void *pgalloc(void);
+void *pgalloc_order(uint order);
+void *pgalloc_nozero(void);
 int pgfree(void *);
+int pgfree_order(void *addr, uint order);
 int pgfreerange(void *start, void *end);
+int pgcarve(uint order);
+int pgref(void *addr);
+void framedump(void);
+void pglistadd(struct pgmemblk *blk, uint order);
+void pglistremove(struct pgmemblk *blk, uint order);
+int pglargestorder(void);
+ulong pgfreepages(void);
+void pgstat(void);
+uint pgzeroidle(uint count);
+void pgzerodrain(void);
+void pgclear(void *pg);
+void pgcopy(void *dst, const void *src);
 
 /* Prototypes mapping virtual addresses to physical addresses */
 int mapAddress(pgtbl pagetable, ulong virtualaddr, ulong physicaladdr,
                ulong length, int attr);
 int mapPage(pgtbl pagetable, page pg, ulong virtualaddr, int attr, ulong physicaladdr);
+ulong *pgLookup(pgtbl pagetable, ulong virtualaddr);
+int unmapAddress(pgtbl pagetable, ulong virtualaddr, ulong length);
+int protectAddress(pgtbl pagetable, ulong virtualaddr, ulong length, int attr);
 
 /* Prototypes for dealing with physical pages */
 pgtbl vm_userinit(int pid, page stack);
+pgtbl vm_usertemplate(void);
+void  vm_userfree(int pid);
+pgtbl vm_userfork(int ppid, int cpid);
+int   vm_cowfault(pgtbl pagetable, ulong virtualaddr);
+int   vm_brk(int pid, ulong addr);
+int   vm_pagefault(int pid, ulong cause, ulong virtualaddr);
+ulong vm_heaprss(int pid);
 void  vm_kerninit(void);
 
+/** Address space id a page table is loaded with: the pid that owns its root */
+#define PGTBL_ASID(pagetable) ((ulong)PG_FRAME(pagetable)->owner)
+
+/** Largest range unmapAddress()/protectAddress() flush page by page */
+#define PG_FLUSHPAGES 32
+
 // Flush the TLB by executing an sfence.vma
 static inline void
 sfence_vma(void)
@@ -88,4 +260,18 @@ sfence_vma(void)
     asm volatile("sfence.vma zero, zero"); // This will flush the entire TLB
 }
 
+// Flush the non-global TLB entries of one address space
+static inline void
+sfence_vma_asid(ulong asid)
+{
+    asm volatile("sfence.vma zero, %0" : : "r"(asid) : "memory");
+}
+
+// Flush the leaf TLB entry of one page in one address space
+static inline void
+sfence_vma_page(ulong virtualaddr, ulong asid)
+{
+    asm volatile("sfence.vma %0, %1" : : "r"(virtualaddr), "r"(asid) : "memory");
+}
+
 #endif                          /* _SAFEMEM_H_ */
@@ -33,6 +33,10 @@ struct syscall_info
 #define SYSCALL_PTJOIN     14 /**< PThread join                     */
 #define SYSCALL_PTLOCK     15 /**< PThread lock                     */
 #define SYSCALL_PTUNLOCK   16 /**< PThread unlock                   */
+#define SYSCALL_IDLE       17 /**< Idle-time kernel housekeeping    */
+#define SYSCALL_FORK       18 /**< Copy the calling process         */
+#define SYSCALL_BRK        19 /**< Set the program break            */
+#define SYSCALL_SBRK       20 /**< Move the program break           */
 extern const struct syscall_info syscall_table[];
 extern int nsyscalls;
 
@@ -42,5 +46,9 @@ syscall user_yield(void);
 syscall user_getc(int descrp);
 syscall user_putc(int descrp, char character);
 syscall user_kill(void);
+syscall user_idle(void);
+syscall user_fork(void);
+syscall user_brk(void *addr);
+void *user_sbrk(long incr);
 
 #endif                          /* __SYSCALL_H__ */
\ No newline at end of file
@@ -14,11 +14,16 @@
 #include <hart.h>
 #include <platform.h>
 #include <interrupt.h>
+#include <irqtrace.h>
 #include <timer.h>
 #include <clock.h>
+#include <ktimer.h>
 #include <endianness.h>
 #include <safemem.h>
+#include <cache.h>
 #include <proc.h>
+#include <ktrace.h>
+#include <profile.h>
 #include <queue.h>
 #include <riscv.h>
 #include <syscall.h>
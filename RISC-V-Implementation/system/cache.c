@@ -0,0 +1,80 @@
+/**
+ * @file cache.c
+ * @provides dcache_clean, dcache_inval, dcache_flush
+ *
+ * Data cache maintenance by address, with the T-Head cache instructions
+ * on the C906.  The kernel needs little of it: devices are mapped
+ * uncached and strongly ordered, the page table walker reads through the
+ * D-cache, and the cache resolves virtual aliases itself, so page table
+ * updates and satp switches need only sfence.vma.  What is left is memory
+ * reached both through the cache and around it, such as a buffer shared
+ * with a DMA device or mapped uncached as well.  Elsewhere these do
+ * nothing.
+ */
+/* Embedded Xinu, Copyright (C) 2024.  All rights reserved. */
+
+#include <xinu.h>
+
+#ifdef _XINU_PLATFORM_RISCV_NEZHA_
+/* dcache.cva, dcache.iva and dcache.civa take their address in a0 */
+#define DCACHE_CVA_A0   ".long 0x0255000b"
+#define DCACHE_IVA_A0   ".long 0x0265000b"
+#define DCACHE_CIVA_A0  ".long 0x0275000b"
+#define DCACHE_OP(op, va) \
+    do { \
+        register ulong a0 asm("a0") = (va); \
+        asm volatile (op :: "r" (a0) : "memory"); \
+    } while (0)
+#define DCACHE_SYNC()   asm volatile (".long 0x0190000b" ::: "memory")
+#endif
+
+/**
+ * Writes back the dirty lines of a range, so memory holds what the
+ * processor last wrote.
+ * @param addr start of the range
+ * @param len  bytes in it
+ */
+void dcache_clean(const void *addr, ulong len)
+{
+#ifdef _XINU_PLATFORM_RISCV_NEZHA_
+    ulong va = (ulong)addr & ~(ulong)(DCACHE_LINE - 1);
+
+    for (; va < (ulong)addr + len; va += DCACHE_LINE)
+        DCACHE_OP(DCACHE_CVA_A0, va);
+    DCACHE_SYNC();
+#endif
+}
+
+/**
+ * Drops the lines of a range without writing them back, so the next read
+ * comes from memory.  Lines only partly in the range lose the rest of
+ * their bytes as well, so the range should start and end on a line.
+ * @param addr start of the range
+ * @param len  bytes in it
+ */
+void dcache_inval(void *addr, ulong len)
+{
+#ifdef _XINU_PLATFORM_RISCV_NEZHA_
+    ulong va = (ulong)addr & ~(ulong)(DCACHE_LINE - 1);
+
+    for (; va < (ulong)addr + len; va += DCACHE_LINE)
+        DCACHE_OP(DCACHE_IVA_A0, va);
+    DCACHE_SYNC();
+#endif
+}
+
+/**
+ * Writes back and then drops the lines of a range.
+ * @param addr start of the range
+ * @param len  bytes in it
+ */
+void dcache_flush(const void *addr, ulong len)
+{
+#ifdef _XINU_PLATFORM_RISCV_NEZHA_
+    ulong va = (ulong)addr & ~(ulong)(DCACHE_LINE - 1);
+
+    for (; va < (ulong)addr + len; va += DCACHE_LINE)
+        DCACHE_OP(DCACHE_CIVA_A0, va);
+    DCACHE_SYNC();
+#endif
+}
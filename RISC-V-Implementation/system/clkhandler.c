@@ -5,37 +5,65 @@
 
 #include <xinu.h>
 
-int resched(void);
-
 /**
  * @ingroup timer
  *
- * Interrupt handler function for the timer interrupt.  This schedules a new
- * timer interrupt to occur at some point in the future, then updates ::clktime
- * and ::clkticks, then wakes sleeping threads if there are any, otherwise
- * reschedules the processor.
+ * Interrupt handler function for the clock, which is armed as a one-shot
+ * for the earliest kernel timer.  This is only the top half: it notes the
+ * latency, takes a profiling sample if one is due, quiets the clock and
+ * leaves the timers to clkexpire(), which runs once interrupts are back
+ * on.
  */
 interrupt clkhandler(void)
 {
-    volatile struct timer *t = (volatile struct timer *)TIMER_BASE;
+    ulong now, late;
 
-    /* Another clock tick passes. */
-    clkticks++;
+    // How long this interrupt waited since the deadline it was armed for
+    now = rdtime();
+    late = now - clkdeadline;
+    if (clkdeadline != TW_NEVER && (long)late > 0 && late > clkmaxlat)
+        clkmaxlat = late;
+    ktrace(KT_CLOCK, late, 0);
+    profclock(now);
 
+#ifdef _XINU_PLATFORM_RISCV_QEMU_
+    // sip.STIP stays up until stimecmp moves past the time CSR
+    clkarm(TW_NEVER);
+#else
     // Clear the pending interrupt by setting it to 1
-    t->irq_sta = TMR0_IRQ_PEND;
+    ((volatile struct timer *)TIMER_BASE)->irq_sta = TMR0_IRQ_PEND;
+#endif
 
-    // Reload the timer
-    t->t0_ctrl |= TMR0_RELOAD;
+    softraise(SOFTIRQ_CLOCK);
+}
 
-    // Wait until bit is cleared
-    while (t->t0_ctrl & TMR0_RELOAD)
-    {
+/**
+ * @ingroup timer
+ *
+ * Bottom half of the clock interrupt.  Runs the timers that are due,
+ * which arms the clock again.
+ */
+interrupt clkexpire(void)
+{
+    irqmask im;
 
-    }
+    im = disable();
+    ktimer_expire();
+    restore(im);
+}
 
-    // Reenable the timer
-    t->t0_ctrl |= TMR0_EN;
+/**
+ * @ingroup timer
+ *
+ * The scheduler tick, a periodic kernel timer at ::CLKTICKS_PER_SEC.
+ * Updates ::clktime and ::clkticks and counts down the time slice; the
+ * resched() itself is left until the bottom halves are done, since a
+ * timer function may not give up the processor.
+ */
+void clktick(struct ktimer *t, void *arg)
+{
+    /* Another clock tick passes. */
+    clkticks++;
 
     // Check if 1000 milliseconds have passed
     if(clkticks == CLKTICKS_PER_SEC)
@@ -51,7 +79,7 @@ interrupt clkhandler(void)
     if (preempt <= 0)
     {
 //	kputc('+');
-        resched();
+        needresched = TRUE;
     }
 #endif
 }
@@ -2,7 +2,7 @@
  * @file     clkinit.c
  *
  */
-/* Embedded Xinu, Copyright (C) 2009.  All rights reserved. */
+/* Embedded Xinu, Copyright (C) 2009, 2024.  All rights reserved. */
 
 #include <xinu.h>
 
@@ -22,6 +22,30 @@ volatile ulong clktime;
 volatile ulong preempt;
 #endif
 
+/** @ingroup timer
+ * Longest wait from the clock expiring to clkhandler() running, in time
+ * counts (platform.clkfreq per second).  Cleared by whoever wants to
+ * measure.  */
+volatile ulong clkmaxlat;
+
+/** @ingroup timer
+ * Time count the clock is armed for, or TW_NEVER.  */
+volatile ulong clkdeadline;
+
+static union
+{
+    struct clkpage clk;
+    uchar page[PAGE_SIZE];
+} clkpagebuf __attribute__ ((aligned(PAGE_SIZE)));
+
+/** @ingroup timer
+ * The clock page, alone in a page of its own so that page can be mapped
+ * read-only everywhere (see ::CLKPAGE).  */
+struct clkpage *const clkpage = &clkpagebuf.clk;
+
+/** The scheduler tick, a periodic kernel timer */
+static struct ktimer clktimer;
+
 /**
  * @ingroup timer
  *
@@ -29,7 +53,9 @@ volatile ulong preempt;
  */
 void clkinit(void)
 {
+#ifndef _XINU_PLATFORM_RISCV_QEMU_
     volatile struct timer *t = (volatile struct timer *)TIMER_BASE;
+#endif
 
 #if PREEMPT
     preempt = QUANTUM;
@@ -37,32 +63,25 @@ void clkinit(void)
 
     clkticks = 0;
     clktime = 0;
+    clkmaxlat = 0;
+    clkdeadline = TW_NEVER;
 
-    // First, configure the timer hardware for T0 periodic interrupt at 1KHz.
-    
-    // This register is the INTERVAL value of the timer
-    // aka how many cycles of the timer hardware between timer interrupts
-    t->t0_intv = TIMER_INTV_1KHZ;
-
-    // This is based on the example in the documentation, for a 1mS delay
+#ifdef _XINU_PLATFORM_RISCV_QEMU_
+    // The CPU timer: stimecmp against the time CSR, no PLIC involved
+    platform.clkfreq = 10000000;
+    timerhandler = clkhandler;
+#else
+    // TIMER0 counts down once from each deadline at the rate of the time
+    // CSR, 24 MHz with no prescaler, and interrupts when it gets to zero.
     // https://dl.linux-sunxi.org/D1/D1_User_Manual_V0.1_Draft_Version.pdf
     // pp. 176-183
-    // Set TIMER0 mode to periodic, 24 MHz oscillator source, prescaler 2
-    t->t0_ctrl = TMR0_MODE_PERIODIC | TMR0_CLK_SRC_OSC24M | TIMER_PRES_1KHZ;
+    t->t0_ctrl = TMR0_MODE_SINGLE | TMR0_CLK_SRC_OSC24M | TMR0_CLK_PRES_1;
     platform.clkfreq = 24000000;
-    // Reload the TIMER0
-    t->t0_ctrl |= TMR0_RELOAD;
-    while ((t->t0_ctrl) & TMR0_RELOAD)
-      {
-	// Spin, waiting for the Reload bit to become 0
-      }
-    t->t0_ctrl |= TMR0_EN; // Enable the timer
 
     // Enable TIMER0 interrupt
     t->irq_en = TMR0_IRQ_EN;
 
-
-    // Second, program platform interrupt controller for TIMER0 source.
+    // Program platform interrupt controller for TIMER0 source.
     
     // PLIC interrupt priority for TIMER0
     uint *reg = (uint *)(PLIC_BASE + TIMER0_IRQVEC);
@@ -73,9 +92,64 @@ void clkinit(void)
 	    (uint *)(PLIC_BASE + PLIC_SIE_REGN + 0x4 * (TIMER0_INT/32));
     *timer_irq_enable_reg |= (1 << (TIMER0_INT % 32));
 
+    /* register clock interrupt */
+    interruptVector[IRQ_TIMER] = clkhandler;
+#endif
+    softvector[SOFTIRQ_CLOCK] = clkexpire;
+
+    // 10^9 << CLK_NSSHIFT fits in 64 bits, so this is the one division
+    clkpage->freq = platform.clkfreq;
+    clkpage->nsmult = (1000000000UL << CLK_NSSHIFT) / platform.clkfreq;
+    clkpage->boot = rdtime();
+
+    // The tick is one kernel timer among others
+    ktimerinit();
+    ktimer_init(&clktimer, clktick, NULL);
+    ktimer_arm(&clktimer, 1000000 / CLKTICKS_PER_SEC,
+               1000000 / CLKTICKS_PER_SEC);
+
     kprintf("Time base %dHz, Clock ticks at %dHz\r\n",
             platform.clkfreq, CLKTICKS_PER_SEC);
+}
 
-    /* register clock interrupt */
-    interruptVector[IRQ_TIMER] = clkhandler;
+/**
+ * @ingroup timer
+ *
+ * Arms the clock to interrupt once, at the given time.  An earlier arming
+ * is forgotten.
+ * @param when time count to interrupt at, or TW_NEVER for not at all
+ */
+void clkarm(ulong when)
+{
+#ifdef _XINU_PLATFORM_RISCV_QEMU_
+    clkdeadline = when;
+    asm volatile ("csrw 0x14D, %0"::"r" (when));        /* stimecmp */
+#else
+    volatile struct timer *t = (volatile struct timer *)TIMER_BASE;
+    ulong now;
+
+    clkdeadline = when;
+    if (TW_NEVER == when)
+    {
+        t->t0_ctrl = TMR0_MODE_SINGLE | TMR0_CLK_SRC_OSC24M | TMR0_CLK_PRES_1;
+        return;
+    }
+
+    // A deadline already past fires as soon as possible; one past the
+    // 32-bit counter fires early and is armed again from there
+    now = rdtime();
+    if (when <= now)
+        t->t0_intv = 1;
+    else if (when - now > 0xFFFFFFFFUL)
+        t->t0_intv = 0xFFFFFFFF;
+    else
+        t->t0_intv = when - now;
+
+    // Load the interval and start counting in one store.  The reload
+    // takes a few cycles of the 24 MHz clock, but nothing here needs to
+    // see it finish: the next write to the control register is the next
+    // arming, an interrupt later.
+    t->t0_ctrl = TMR0_MODE_SINGLE | TMR0_CLK_SRC_OSC24M | TMR0_CLK_PRES_1
+        | TMR0_RELOAD | TMR0_EN;
+#endif
 }
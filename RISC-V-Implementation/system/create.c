@@ -7,7 +7,7 @@
  */
 /**
  * @file create.c
- * @provides create, newpid, userret
+ * @provides create, kstackinit, newpid, userret
  *
  * COSC 3250 Assignment 4
  */
@@ -17,7 +17,6 @@
 #include <xinu.h>
 
 
-static pid_typ newpid(void);
 void userret(void);
 void *pgalloc(void);
 
@@ -33,106 +32,134 @@ void *pgalloc(void);
 syscall create(void *funcaddr, ulong ssize, unsigned int priority, char *name, ulong nargs, ...)
 {
     ulong *saddr;               /* stack address                */
-    ulong pid;                  /* stores new process id        */
+    ulong *top;                 /* lowest word used so far      */
+    ulong *swaparea;            /* user registers               */
+    pid_typ pid;                /* stores new process id        */
     pcb *ppcb;                  /* pointer to proc control blk  */
     ulong i;
     va_list ap;                 /* points to list of var args   */
-    ulong pads = 0;             /* padding entries in record.   */
-
-
+    ulong pads = 0;             /* args passed on the stack     */
+    irqmask im;
 
     if (ssize < MINSTK)
         ssize = MINSTK;
 
-
     ssize = (ulong)((((ulong)(ssize + 3)) >> 2) << 2);
     /* round up to even boundary    */
     saddr = (ulong *)pgalloc();     /* allocate new stack and pid   */
-    ulong *procStackAddr = saddr;
+    if (((ulong *)SYSERR) == saddr)
+    {
+        return SYSERR;
+    }
+
+    // The slot is claimed at once; the rest runs with interrupts on
+    im = disable();
     pid = newpid();
     /* a little error checking      */
-    if ((((ulong *)SYSERR) == saddr) || (SYSERR == pid))
+    if (SYSERR == pid)
     {
+        restore(im);
+        pgfree(saddr);
         return SYSERR;
     }
-
-
     numproc++;
     ppcb = &proctab[pid];
-   
-    // Setup PCB entry for new process.
+    ppcb->state = PRSUSP;
+    restore(im);
 
+    // Setup PCB entry for new process.
     ppcb->pagetable = vm_userinit(pid, saddr);
+    if ((pgtbl)SYSERR == ppcb->pagetable || SYSERR == kstackinit(pid))
+    {
+        if ((pgtbl)SYSERR != ppcb->pagetable)
+            vm_userfree(pid);
+        pgfree(saddr);
+        im = disable();
+        numproc--;
+        ppcb->state = PRFREE;
+        restore(im);
+        return SYSERR;
+    }
     ppcb->tickets = priority; 
-    ppcb->state = PRSUSP;                // Set process state to runnable
+    bzero(ppcb->fpregs, sizeof(ppcb->fpregs));  // FP starts out zeroed
+    ppcb->fptraps = 0;
     ppcb->stkbase = saddr;         // Set stack base to base address of allocated stack
     ppcb->stklen = ssize;                 // Set stack length to the size of the allocated stack
     strncpy((*ppcb).name, name, PNMLEN);                    // Set process name
-   
-    //traverse to top of page table here
-
-    saddr += 512;
 
-    /* Initialize stack with accounting block. */
-    *saddr = STACKMAGIC;
-    *--saddr = pid;
-    *--saddr = ppcb->stklen;
-    *--saddr = (ulong)ppcb->stkbase;
+    /* Initialize stack with accounting block at the top of the page. */
+    top = saddr + PAGE_SIZE / sizeof(ulong);
+    *--top = STACKMAGIC;
+    *--top = pid;
+    *--top = ppcb->stklen;
+    *--top = (ulong)ppcb->stkbase;
 
-
-    /* Handle variable number of arguments passed to starting function   */
-    if (nargs)
-    {
-        pads = ((nargs - 1) / 8) * 8;
-    }
-    /* If more than 8 args, pad record size to multiple of native memory */
-    /*  transfer size.  Reserve space for extra args                     */
-    for (i = 0; i < pads; i++)
+    /* Arguments past the first ARG_REG_MAX go on the stack, at sp up    */
+    if (nargs > ARG_REG_MAX)
     {
-        *--saddr = 0;
+        pads = nargs - ARG_REG_MAX;
     }
+    top = (ulong *)((ulong)(top - pads) & ~0xFUL);
 
+    // The user registers start out in the swap area; the first return
+    // to user mode (userstart) loads them like any other trap return.
+    swaparea = ppcb->swaparea;
+    swaparea[CTX_PC] = (ulong)funcaddr;
+    swaparea[CTX_RA] = (ulong)userret;
+    swaparea[CTX_SP] = PROCSTACKADDR + ((ulong)top - (ulong)saddr);
 
-    //populate the first 32 registers of the stack wtih 0s as fillers
-    for(i = 0; i < 32; i++){
-        *--saddr = 0;
+    va_start(ap, nargs);
+    for (i = 0; i < nargs; i++)
+    {
+        if (i < ARG_REG_MAX)
+            swaparea[CTX_A0 + i] = va_arg(ap, ulong);
+        else
+            top[i - ARG_REG_MAX] = va_arg(ap, ulong);
     }
+    va_end(ap);
 
+    return pid;
+}
 
+/**
+ * Gives a user process its own kernel stack.  Traps from the process
+ * run on it, and ctxsw() leaves the process's kernel state there while
+ * it is switched out.  The stack starts with a ctxsw() frame that
+ * returns to userstart with the process's satp in s0 and its swap area in
+ * s1, so the first switch to the process enters user mode through the
+ * swap area.
+ * @param pid the process, with its page table and swap area set up
+ * @return OK, or SYSERR if no memory is left
+ */
+syscall kstackinit(pid_typ pid)
+{
+    pcb *ppcb = &proctab[pid];
+    ulong *frame;
 
-
-    // Initialize process context.
-    *((saddr)+(CTX_PC)) = (ulong)funcaddr;      // Set program counter
-    *((saddr)+(CTX_RA)) = (ulong)userret;     // set return address     
-    *((saddr)+(CTX_SP)) = (ulong)saddr;  // Set stack pointer
- 
-
-    // Place arguments into activation record.
-    // See K&R 7.3 for an example using va_start, va_arg, and va_end macros for variable argument functions.
-
-
-    //stick with less than 8 args storing in context registers set empty to 0
-    //where is activation record
-    ulong ival;
-    int w = 0;
-    va_start(ap, 8);
-    ulong *p;
-    for(p = ap; *p; p++){
-        ival = va_arg(ap, ulong);
-        *(w + saddr) = ival;
-        w++;
-
-        if (pads != 0 && w == 8) w+=24;
+    ppcb->kstack = pgalloc_nozero();
+    if ((void *)SYSERR == ppcb->kstack)
+    {
+        ppcb->kstack = NULL;
+        return SYSERR;
     }
-    ppcb->stkptr = saddr;
+    PG_FRAME(ppcb->kstack)->owner = pid;
 
-    saddr[CTX_SP] = (ulong)(procStackAddr + 512 - (ulong)ppcb->stkbase - (ulong)saddr);
+    frame = (ulong *)((ulong)ppcb->kstack + KSTACKSIZE) - CTXSW_FRAME;
+    bzero(frame, CTXSW_FRAME * sizeof(ulong));
+    frame[CTXSW_RA] = (ulong)userstart;
+    frame[CTXSW_S0] = MAKE_SATP(pid, ppcb->pagetable);
+    frame[CTXSW_S1] = SWAPAREAVA(ppcb->swaparea);
+    ppcb->stkptr = frame;
 
-    va_end(ap);
-    return pid;
+    ppcb->swaparea[CTX_KERNSP] = (ulong)ppcb->kstack + KSTACKSIZE;
+
+    return OK;
 }
 
-static pid_typ newpid(void)
+/**
+ * @return a free process table slot, or SYSERR if the table is full
+ */
+pid_typ newpid(void)
 {
     pid_typ pid;                /* process id to return     */
     static pid_typ nextpid = 0;
@@ -1,6 +1,6 @@
 /**
  * @file dispatch.c
- * @provides create, newpid, userret
+ * @provides dispatch, extintr, timerintr, softintr, softraise
  *
  */
 /* Embedded XINU, Copyright (C) 2008.  All rights reserved. */
@@ -15,16 +15,27 @@
  * Dispatch the trap or exception handler, called via interrupt.S
  * @param cause  The value of the scause register 
  * @param stval  The value of the stval register  
- * @param frame  The stack pointer of the process that caused the interupt 
+ * @param frame  The trap frame interrupt.S left on the kernel stack
  * @param program_counter  The value of the sepc register 
+ * @return the satp of the process to return to; ignored for a trap
+ *         taken in the kernel
  */
 
 ulong dispatch(ulong cause, ulong val, ulong *frame, ulong *program_counter) {
     ulong swi_opcode;
+    int result;
     
     pcb *ppcb = &proctab[currpid];
 
-    if((long)cause > 0) {
+    ktrace(KT_TRAP, cause, val);
+
+    // The kernel itself faulted; only an interrupt may nest in it.  Its
+    // registers are not in a swap area, so there are none to show
+    if ((get_sstatus() & SSTATUS_S_MODE) && (long)cause >= 0) {
+        xtrap(NULL, cause, val, program_counter);
+    }
+
+    if((long)cause >= 0) {
         cause = cause << 1;
         cause = cause >> 1;
 
@@ -43,43 +54,191 @@ ulong dispatch(ulong cause, ulong val, ulong *frame, ulong *program_counter) {
             swi_opcode = *(ulong *)(*program_counter);
             ulong syscall_number = ppcb->swaparea[CTX_A7]; //Extracting the syscall number
 
-            //Pass the system call number and any arguments into syscall_dispatch
+            // Record where the process resumes; fork() copies it and
+            // interrupt.S loads sepc from it on the way out
+            ppcb->swaparea[CTX_PC] = (ulong)program_counter + 4;
+
+            //Pass the system call number and any arguments into syscall_dispatch.
+            //The call runs with interrupts on, so a long one does not hold
+            //off the timer and the process can be preempted inside it
+            enable();
             ulong syscall_retval = syscall_dispatch(syscall_number, &ppcb->swaparea[CTX_A0]);
+            disable();
 
             //Set the return value in the appropriate spot
             ppcb->swaparea[CTX_A0] = syscall_retval;
-
-            //Update the program counter appropriately with set_setpc and move to next instruction
-            set_sepc((ulong)(program_counter) + 4);
         } 
+        else if ((cause == E_INSTRUCTION_PAGEFAULT || cause == E_LOAD_PAGEFAULT
+                  || cause == E_STORE_AMO_PAGEFAULT) && ppcb->swaparea != NULL) {
+            // sret retries the access once the fault is resolved; a
+            // process that touched memory it may not is killed, not the system
+            enable();
+            result = vm_pagefault(currpid, cause, val);
+            disable();
+            if (SYSERR == result) {
+                kprintf("\r\nProcess %d (%s): %s at 0x%016lX, pc 0x%016lX, killed\r\n",
+                        currpid, ppcb->name, trap_names[cause], val,
+                        (ulong)program_counter);
+                kill(currpid);
+            }
+        }
+        else if (cause == E_ILLEGAL_INSTRUCTION && ppcb->swaparea != NULL
+                 && OK == fputrap()) {
+            // First FP instruction of this time slice; sret runs it again
+        }
         else {
             // If the trap is not an environment call from U-Mode call xtrap
             xtrap(ppcb->swaparea, cause, val, program_counter);
         }
     }
     else {
+        // Only reached with stvec in direct mode, or for a cause the
+        // vector has no stub for
         cause = cause << 1;
         cause = cause >> 1;
-        uint irq_num;
-
-        volatile uint *int_sclaim = (volatile uint *)(PLIC_BASE + 0x201004);
-        irq_num = *int_sclaim;
-
-        if(cause == I_SUPERVISOR_EXTERNAL) {
-            interrupt_handler_t handler = interruptVector[irq_num];
-
-            *int_sclaim = irq_num;
-            if (handler)
-            {
-                (*handler) ();
-            } else {
-                kprintf("ERROR: No handler registered for interrupt %u\r\n",
-                        irq_num);
-                while (1)
-                    ;
-            }
+
+        if (cause == I_SUPERVISOR_EXTERNAL) {
+            extintr(NULL);
+        }
+        else if (cause == I_SUPERVISOR_TIMER) {
+            timerintr(NULL);
+        }
+        else if (cause == I_SUPER_SOFTWARE) {
+            softintr(NULL);
         }
     }
     return MAKE_SATP(currpid, ppcb->pagetable);   
 }
 
+
+/**
+ * Handles a supervisor external interrupt: claims the source from the
+ * PLIC, completes it and runs the handler registered for it.
+ * @param trace the interrupt's IRQTRACE words, or NULL (see irqrun())
+ */
+void extintr(ulong *trace)
+{
+    volatile uint *int_sclaim = (volatile uint *)(PLIC_BASE + PLIC_SCLAIM_REG);
+    interrupt_handler_t handler;
+    uint irq_num;
+
+    irq_num = *int_sclaim;
+    if (0 == irq_num)
+    {
+        // Another hart claimed it first, or it went away
+        return;
+    }
+
+    ktrace(KT_IRQ, irq_num, 0);
+    handler = interruptVector[irq_num];
+    *int_sclaim = irq_num;
+    if (handler)
+    {
+        irqrun(irq_num, handler, trace);
+    }
+    else
+    {
+        kprintf("ERROR: No handler registered for interrupt %u\r\n",
+                irq_num);
+        while (1)
+            ;
+    }
+}
+
+/**
+ * Handles a supervisor timer interrupt.  The CPU timer is not behind the
+ * PLIC, so there is nothing to claim.  With no handler registered the
+ * interrupt is turned off, since it stays pending until stimecmp moves.
+ * @param trace the interrupt's IRQTRACE words, or NULL (see irqrun())
+ */
+void timerintr(ulong *trace)
+{
+    if (timerhandler)
+    {
+        irqrun(IRQ_STIMER, timerhandler, trace);
+    }
+    else
+    {
+        sie_clear(RISCV_SIE_STIE);
+    }
+}
+
+/**
+ * Runs the pending bottom halves, with interrupts on so a device is not
+ * kept waiting behind them, then softhandler if one is set.  One pass
+ * runs at a time: a software interrupt taken during it leaves its bits
+ * for the loop here.  A bottom half that wants another process to run
+ * sets needresched, since the processor may only be given up once the
+ * pass is over.
+ */
+static interrupt softrun(void)
+{
+    static bool softactive = FALSE;
+    ulong pending;
+    uint n;
+    irqmask im;
+
+    if (softactive)
+    {
+        return;
+    }
+    softactive = TRUE;
+
+    enable();
+    while (softpending != 0)
+    {
+        im = disable();
+        pending = softpending;
+        softpending = 0;
+        restore(im);
+
+        for (n = 0; n < NSOFTIRQ; n++)
+        {
+            if ((pending & (1UL << n)) && softvector[n] != NULL)
+                (*softvector[n]) ();
+        }
+    }
+    if (softhandler)
+    {
+        (*softhandler) ();
+    }
+    // sepc and sstatus must survive until the sret
+    disable();
+    softactive = FALSE;
+
+    // Raised after the loop looked, while a nested call was turned away
+    if (softpending != 0)
+        sip_set(RISCV_SIP_SSIP);
+
+    if (needresched)
+    {
+        needresched = FALSE;
+        resched();
+    }
+}
+
+/**
+ * Handles a supervisor software interrupt, clearing it first so a
+ * bottom half may raise another.
+ * @param trace the interrupt's IRQTRACE words, or NULL (see irqrun())
+ */
+void softintr(ulong *trace)
+{
+    sip_clear(RISCV_SIP_SSIP);
+    irqrun(IRQ_SSOFT, softrun, trace);
+}
+
+/**
+ * Marks a bottom half pending and raises the software interrupt that
+ * runs it.  From an interrupt handler it runs once the handler returns.
+ * @param n the bottom half, below NSOFTIRQ
+ */
+void softraise(uint n)
+{
+    irqmask im;
+
+    im = disable();
+    softpending |= 1UL << n;
+    sip_set(RISCV_SIP_SSIP);
+    restore(im);
+}
@@ -0,0 +1,73 @@
+/**
+ * @file fork.c
+ * @provides forkproc
+ *
+ */
+/* Embedded XINU, Copyright (C) 2024.  All rights reserved. */
+
+#include <xinu.h>
+
+/**
+ * Makes a copy of a user process that shares its memory copy-on-write
+ * (see vm_userfork()).  The child resumes where the parent last trapped
+ * into the kernel with the same registers, except that a0 is 0 so it can
+ * tell itself apart.  It is left suspended.
+ * @param ppid the process to copy
+ * @return the pid of the child, or SYSERR
+ */
+syscall forkproc(pid_typ ppid)
+{
+    pcb *parent, *child;
+    pid_typ pid;
+    irqmask im;
+
+    if (isbadpid(ppid) || NULL == proctab[ppid].swaparea)
+    {
+        return SYSERR;
+    }
+    parent = &proctab[ppid];
+
+    // Claim the slot before copying, which runs with interrupts on
+    im = disable();
+    pid = newpid();
+    if (SYSERR == pid)
+    {
+        restore(im);
+        return SYSERR;
+    }
+    child = &proctab[pid];
+    child->state = PRSUSP;
+    numproc++;
+    restore(im);
+
+    child->pagetable = vm_userfork(ppid, pid);
+    if ((pgtbl)SYSERR == child->pagetable || SYSERR == kstackinit(pid))
+    {
+        if ((pgtbl)SYSERR != child->pagetable)
+            vm_userfree(pid);
+        im = disable();
+        numproc--;
+        child->state = PRFREE;
+        restore(im);
+        return SYSERR;
+    }
+    child->tickets = parent->tickets;
+    child->stkbase = NULL;      /* the stack is a copy-on-write mapping */
+    child->stklen = parent->stklen;
+    memcpy(child->vma, parent->vma, sizeof(child->vma));
+    child->minflt = 0;
+    child->majflt = 0;
+
+    // The parent's latest FP registers may only be in the FPU
+    if (ppid == currpid)
+        fpuflush();
+    memcpy(child->fpregs, parent->fpregs, sizeof(child->fpregs));
+    child->fptraps = 0;
+    strncpy(child->name, parent->name, PNMLEN);
+
+    // Resume through the copied register state; kstackinit() has
+    // already pointed the child's first switch at userstart
+    child->swaparea[CTX_A0] = 0;
+
+    return pid;
+}
@@ -0,0 +1,75 @@
+/**
+ * @file fpu.c
+ * @provides fpuswitch, fpuflush, fputrap
+ *
+ * Lazy floating-point context.  A process starts every time slice with
+ * sstatus.FS off, so its first F or D instruction traps and fputrap()
+ * turns the FPU on, loading the process's registers only if they are not
+ * the ones already there.  The registers are saved on the way out only
+ * if the process wrote them (FS dirty).  A process that never touches the
+ * FPU never pays for it.  The kernel itself must not use the FPU.
+ */
+/* Embedded XINU, Copyright (C) 2024.  All rights reserved. */
+
+#include <xinu.h>
+
+/**
+ * Saves the running process's FP registers into its PCB if it has
+ * written them since they were last saved, leaving the FPU on and clean.
+ */
+void fpuflush(void)
+{
+    if (SSTATUS_FS_DIRTY == (get_sstatus() & SSTATUS_FS))
+    {
+        fpusave(proctab[currpid].fpregs);
+        sstatus_clear(SSTATUS_FS);
+        sstatus_set(SSTATUS_FS_CLEAN);
+    }
+}
+
+/**
+ * Called by resched() when the processor is given to another process.
+ * Saves the outgoing process's FP registers if they are dirty and turns
+ * the FPU off, so the incoming process traps on its first FP instruction.
+ * @param oldproc the process giving up the processor
+ */
+void fpuswitch(pcb *oldproc)
+{
+    ulong fs = get_sstatus() & SSTATUS_FS;
+
+    // A process that has just killed itself has nothing worth keeping
+    if (SSTATUS_FS_DIRTY == fs && oldproc->state != PRFREE)
+    {
+        fpusave(oldproc->fpregs);
+    }
+    sstatus_clear(SSTATUS_FS);
+}
+
+/**
+ * Handles an illegal instruction trap from a process.  If the FPU was off
+ * the instruction is taken to be a floating-point one: the FPU is turned
+ * on, the process's registers are loaded unless they are still in place,
+ * and the instruction is run again on return.  An illegal instruction
+ * with the FPU already on is a real one.
+ * @return OK if the instruction should be retried, otherwise SYSERR
+ */
+syscall fputrap(void)
+{
+    if ((get_sstatus() & SSTATUS_FS) != SSTATUS_FS_OFF)
+    {
+        return SYSERR;
+    }
+
+    sstatus_set(SSTATUS_FS_CLEAN);
+    if (fpowner != currpid)
+    {
+        fpurestore(proctab[currpid].fpregs);
+        fpowner = currpid;
+        // The registers match the PCB again
+        sstatus_clear(SSTATUS_FS);
+        sstatus_set(SSTATUS_FS_CLEAN);
+    }
+    proctab[currpid].fptraps++;
+
+    return OK;
+}
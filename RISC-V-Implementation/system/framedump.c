@@ -0,0 +1,95 @@
+/**
+ * @file framedump.c
+ * @provides framedump
+ *
+ */
+/* Embedded Xinu, Copyright (C) 2024.  All rights reserved. */
+
+#include <xinu.h>
+
+/** Most shared frames listed individually by framedump() */
+#define FRAMEDUMP_SHARED 16
+
+/**
+ * Prints how the managed physical frames are being used: totals by kind,
+ * the frames held by each process, and the frames that are shared.  Any
+ * frame owned by a process slot that is now free is a leak.
+ */
+void framedump(void)
+{
+    struct frame *fr;
+    ulong nfree = 0, nzero = 0, nkern = 0, nslab = 0, npgtbl = 0;
+    ulong nuser = 0, nshared = 0, nleaked = 0, nlisted = 0;
+    ulong byowner[NPROC];
+    ulong i;
+    int pid;
+
+    for (pid = 0; pid < NPROC; pid++)
+        byowner[pid] = 0;
+
+    for (i = 0; i < PG_INDEX(pgend); i++)
+    {
+        fr = &frametab[i];
+
+        // Frames of an uncarved extent have no frame table entry yet
+        if (!pgcarved(pgbase + i * PAGE_SIZE))
+        {
+            nfree++;
+            continue;
+        }
+
+        // Frames inside a free block other than its head have no flags
+        if (0 == fr->flags || (fr->flags & FR_FREE))
+        {
+            nfree++;
+            continue;
+        }
+        if (fr->flags & FR_ZEROED)
+        {
+            nzero++;
+            continue;
+        }
+
+        if (fr->flags & FR_PGTBL)
+            npgtbl++;
+        else if (fr->flags & FR_SLAB)
+            nslab++;
+        else
+            nkern++;
+        if (fr->flags & FR_USER)
+            nuser++;
+
+        if (fr->owner >= 0 && fr->owner < NPROC)
+        {
+            byowner[fr->owner]++;
+            if (PRFREE == proctab[fr->owner].state)
+                nleaked++;
+        }
+
+        if (fr->refcount > 1 || fr->mapcount > 1)
+        {
+            nshared++;
+            if (nlisted++ < FRAMEDUMP_SHARED)
+            {
+                kprintf("  shared 0x%08lX ref %u map %u owner %d\r\n",
+                        pgbase + i * PAGE_SIZE, fr->refcount,
+                        fr->mapcount, fr->owner);
+            }
+        }
+    }
+
+    kprintf("frames: %lu free, %lu zeroed, %lu kernel, %lu slab, "
+            "%lu page table\r\n", nfree, nzero, nkern, nslab, npgtbl);
+    kprintf("        %lu user mapped, %lu shared, %lu owned by dead "
+            "processes\r\n", nuser, nshared, nleaked);
+
+    for (pid = 0; pid < NPROC; pid++)
+    {
+        if (byowner[pid] > 0)
+        {
+            kprintf("  pid %2d %-16s %lu frames\r\n", pid,
+                    (PRFREE == proctab[pid].state) ? "(free)" :
+                    proctab[pid].name, byowner[pid]);
+        }
+    }
+}
@@ -20,15 +20,28 @@ qid_typ readylist;              /* List of READY processes               */
 /* Active system status */
 int numproc;                    /* Number of live user processes         */
 int currpid;                    /* Id of currently running process       */
+int fpowner = BADPID;           /* Process whose state is in the FPU     */
+void *deadkstack;               /* Kernel stack of a suicide, to free    */
 
 /* Params set by startup.S */
 void *memheap;                  /* Bottom of heap (top of O/S stack)     */
 ulong cpuid;                    /* Processor id                          */
 
 ulong *_kernpgtbl;              /* Kernel page table address             */
-ulong *_kernsp;                 /* Kernel stack pointer                  */
-struct pgmemblk *pgfreelist = NULL;
-                                /* Linked list of physical free pages    */
+ulong *_userpgtbl;              /* Root shared by user page tables       */
+struct kmcache kmcachetab[NKMCACHE];    /* Kernel object caches          */
+struct kmcache *swapcache;      /* Cache of per-process swap areas       */
+struct kmcache *pgtblcache;     /* Cache of page table pages             */
+struct pgfreearea pgfreearea[PG_MAXORDER + 1];
+                                /* Buddy free lists of physical blocks   */
+struct pgextent pgextent[PG_NEXTENT];   /* Free memory not yet carved    */
+uint pgnextent = 0;             /* Number of entries in pgextent         */
+struct frame *frametab = NULL;  /* Metadata of each managed frame        */
+ulong pgbase = 0;               /* First frame managed by the allocator  */
+ulong pgend = 0;                /* End of the managed frames             */
+struct pgmemblk *pgzerolist = NULL;
+                                /* Pool of pre-zeroed physical frames    */
+uint pgzerocount = 0;           /* Number of frames in the zeroed pool   */
 uint pgtbl_nents = 0;           /* Number of pages in the entire system  */
 
 struct platform platform;       /* Platform specific configuration       */
@@ -37,11 +50,18 @@ interrupt_handler_t interruptVector[ALLWINNER_D1_NUM_IRQS];
 /** Table of Xinu's interrupt handler functions.  
  * This is an array mapping IRQ numbers to handler functions.  
  */
+interrupt_handler_t timerhandler = NULL;    /* CPU timer, not on the PLIC    */
+interrupt_handler_t softhandler = NULL;     /* supervisor software interrupt */
+interrupt_handler_t softvector[NSOFTIRQ];   /* bottom halves                 */
+volatile ulong softpending = 0;             /* bottom halves raised          */
+volatile bool needresched = FALSE;          /* a bottom half wants resched() */
 
 process nullproc(void)
 {
     while (1)
     {
+        /* Spend idle time refilling the pool of zeroed frames */
+        user_idle();
         user_yield();
     }
 }
@@ -57,15 +77,22 @@ void nulluser(void)
     /* Standard Embedded Xinu processor and memory info */
     welcome();
 
-    /* Create the linked list of free physical pages    */
+    /* Create the buddy free lists of physical pages    */
     // TODO: Uncomment these lines once you feel paging is working
     kprintf("Creating list of physical frames...\r\n");
     pgInit();
+    kminit();
 
     /* Setup memory protection for kernel.  Turn paging on for the kernel.  */
     // TODO: Uncomment this line once you feel paging is working
     vm_kerninit();
 
+    kprintf("Reached main() after %lu cycles\r\n", clk_cycles());
+
+    /* The kernel takes interrupts from here on, and may be preempted */
+    set_sscratch(0);
+    enable();
+
     /* Call the main program */
     main();
 
@@ -141,6 +168,7 @@ static int sysinit(void)
     ppcb->stkbase = (void *)&_end;
     ppcb->stklen = (ulong)memheap - (ulong)&_end;
     ppcb->stkptr = NULL;
+    ppcb->kstack = NULL;        /* runs on the boot stack */
     /**
      * TODO: This won't compile properly until you add necessary changes to
      * proc.h
@@ -152,6 +180,8 @@ static int sysinit(void)
 
     clkinit();
 
+    uartinit();
+
     seed_random(SEED);
 
     return OK;
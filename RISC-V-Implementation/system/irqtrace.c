@@ -0,0 +1,246 @@
+/**
+ * @file irqtrace.c
+ * @provides irqrun, irqtrace_exit, irqoffend, irqtrace_reset, irqstat
+ *
+ * Interrupt latency tracing.  The trapvec stubs stamp the cycle counter
+ * as an interrupt enters and again on the way out; irqrun() stamps it as
+ * the handler is called.  disable() stamps it when it turns interrupts
+ * off, and the next point that turns them back on, restore(), enable()
+ * or a trap return, closes the window.  With IRQTRACE off only irqrun()
+ * is left, and it just calls the handler.
+ */
+/* Embedded Xinu, Copyright (C) 2024.  All rights reserved. */
+
+#include <xinu.h>
+
+#if IRQTRACE
+struct irqstat irqstats[NIRQSTAT];
+ulong irqswitches = 0;
+ulong irqoffstart = 0;
+ulong irqoffwhere = 0;
+ulong irqoffmax = 0;
+ulong irqofffrom = 0;
+ulong irqoffto = 0;
+
+/**
+ * Finds the statistics slot of an interrupt source, taking a free one
+ * the first time the source is seen.
+ * @param irq the source
+ * @return its slot, or the last slot if all are taken
+ */
+static struct irqstat *irqslot(uint irq)
+{
+    struct irqstat *stat;
+    uint i;
+
+    for (i = 0; i < NIRQSTAT - 1; i++)
+    {
+        stat = &irqstats[i];
+        if (stat->irq == irq)
+            return stat;
+        if (0 == stat->irq)
+        {
+            stat->irq = irq;
+            stat->latmin = stat->runmin = (ulong)-1;
+            return stat;
+        }
+    }
+
+    stat = &irqstats[NIRQSTAT - 1];
+    if (0 == stat->irq)
+    {
+        stat->irq = IRQ_OTHER;
+        stat->latmin = stat->runmin = (ulong)-1;
+    }
+    return stat;
+}
+
+/**
+ * Prints the name of an interrupt source in six columns.
+ */
+static void irqlabel(uint irq)
+{
+    if (IRQ_STIMER == irq)
+        kprintf("stimer");
+    else if (IRQ_SSOFT == irq)
+        kprintf("ssoft ");
+    else if (IRQ_OTHER == irq)
+        kprintf("other ");
+    else
+        kprintf("%-6u", irq);
+}
+#endif
+
+/**
+ * Calls an interrupt handler, charging its latency to its source.
+ * @param irq     the source, a PLIC interrupt number or IRQ_STIMER/IRQ_SSOFT
+ * @param handler the handler
+ * @param trace   the IRQT_WORDS interrupt.S keeps in the trap frame, or
+ *                NULL if the interrupt came through dispatch()
+ */
+void irqrun(uint irq, interrupt_handler_t handler, ulong *trace)
+{
+#if IRQTRACE
+    struct irqstat *stat;
+    ulong lat, switches;
+
+    if (NULL == trace)
+    {
+        (*handler) ();
+        return;
+    }
+
+    lat = clk_cycles() - trace[IRQT_ENTRY];
+    stat = irqslot(irq);
+    if (lat < stat->latmin)
+        stat->latmin = lat;
+    if (lat > stat->latmax)
+        stat->latmax = lat;
+    stat->lattotal += lat;
+
+    switches = irqswitches;
+    (*handler) ();
+
+    // A handler that gave up the processor would be charged for every
+    // process that ran before it got it back
+    if (switches == irqswitches)
+    {
+        trace[IRQT_STAT] = (ulong)stat;
+    }
+    else
+    {
+        trace[IRQT_STAT] = 0;
+        stat->switched++;
+    }
+#else
+    (*handler) ();
+#endif
+}
+
+/**
+ * Called by interrupt.S after the handler returns, just before it
+ * restores the interrupted registers and executes sret.
+ * @param trace the IRQT_WORDS irqrun() was given
+ */
+void irqtrace_exit(ulong *trace)
+{
+#if IRQTRACE
+    struct irqstat *stat = (struct irqstat *)trace[IRQT_STAT];
+    ulong run;
+    uint k;
+
+    if (NULL == stat)
+    {
+        return;
+    }
+    trace[IRQT_STAT] = 0;
+
+    run = clk_cycles() - trace[IRQT_ENTRY];
+    stat->count++;
+    if (run < stat->runmin)
+        stat->runmin = run;
+    if (run > stat->runmax)
+        stat->runmax = run;
+    stat->runtotal += run;
+
+    for (k = 0; k < IRQHIST - 1 && (run >> (k + 1)) != 0; k++)
+        ;
+    stat->hist[k]++;
+#endif
+}
+
+/**
+ * Closes the window opened by the last disable() that turned interrupts
+ * off, if it is still open, and keeps it if it is the longest so far.
+ * @param pc where interrupts come back on, or 0 for a trap return
+ */
+void irqoffend(ulong pc)
+{
+#if IRQTRACE
+    ulong len;
+
+    if (0 == irqoffstart)
+    {
+        return;
+    }
+
+    len = clk_cycles() - irqoffstart;
+    irqoffstart = 0;
+    if (len > irqoffmax)
+    {
+        irqoffmax = len;
+        irqofffrom = irqoffwhere;
+        irqoffto = pc;
+    }
+#endif
+}
+
+/**
+ * Clears all interrupt statistics.
+ */
+void irqtrace_reset(void)
+{
+#if IRQTRACE
+    irqmask im;
+
+    im = disable();
+    bzero(irqstats, sizeof(irqstats));
+    irqoffmax = 0;
+    irqofffrom = 0;
+    irqoffto = 0;
+    restore(im);
+#endif
+}
+
+/**
+ * Prints the interrupt statistics gathered since boot or the last
+ * irqtrace_reset().
+ */
+void irqstat(void)
+{
+#if IRQTRACE
+    struct irqstat *stat;
+    uint i, k;
+
+    kprintf("irq       count switched   lat min   avg     max"
+            "   total min   avg     max\r\n");
+    for (i = 0; i < NIRQSTAT; i++)
+    {
+        stat = &irqstats[i];
+        if (0 == stat->irq || 0 == stat->count)
+            continue;
+
+        irqlabel(stat->irq);
+        kprintf(" %8lu %8lu %9lu %5lu %7lu %11lu %5lu %7lu\r\n",
+                stat->count, stat->switched,
+                stat->latmin, stat->lattotal / (stat->count + stat->switched),
+                stat->latmax, stat->runmin, stat->runtotal / stat->count,
+                stat->runmax);
+    }
+
+    kprintf("\r\ntotal cycles, log2 buckets:\r\n");
+    for (i = 0; i < NIRQSTAT; i++)
+    {
+        stat = &irqstats[i];
+        if (0 == stat->irq || 0 == stat->count)
+            continue;
+
+        irqlabel(stat->irq);
+        for (k = 0; k < IRQHIST; k++)
+        {
+            if (stat->hist[k] != 0)
+                kprintf(" 2^%u:%u", k, stat->hist[k]);
+        }
+        kprintf("\r\n");
+    }
+
+    kprintf("\r\nlongest interrupts-off window: %lu cycles, "
+            "disable() from 0x%lX to ", irqoffmax, irqofffrom);
+    if (irqoffto != 0)
+        kprintf("0x%lX\r\n", irqoffto);
+    else
+        kprintf("trap return\r\n");
+#else
+    kprintf("irqstat: built without IRQTRACE\r\n");
+#endif
+}
@@ -15,9 +15,12 @@
 syscall kill(int pid)
 {
     pcb *ppcb;                  /* points to process control block for pid */
+    irqmask im;
 
+    im = disable();
     if (isbadpid(pid) || (PRFREE == (ppcb = &proctab[pid])->state))
     {
+        restore(im);
         return SYSERR;
     }
 
@@ -25,6 +28,38 @@ syscall kill(int pid)
 
     numproc = numproc - 1;
 
+    // A new process in this slot must not inherit the FP registers
+    if (fpowner == pid)
+        fpowner = BADPID;
+
+    // Give back the page tables, swap area and stack of a user process.
+    // A forked child has no stack allocation of its own; its stack is a
+    // mapping, released by vm_userfree().
+    if (ppcb->pagetable != NULL && ppcb->pagetable != _kernpgtbl)
+    {
+        vm_userfree(pid);
+        if (ppcb->stkbase != NULL)
+            pgfree(ppcb->stkbase);
+    }
+
+    // A process killing itself is still running on its kernel stack, so
+    // resched() frees that one once it has switched away for good.  An
+    // earlier suicide's stack is no longer in use by then.
+    if (ppcb->kstack != NULL)
+    {
+        if (PRCURR == ppcb->state)
+        {
+            if (deadkstack != NULL)
+                pgfree(deadkstack);
+            deadkstack = ppcb->kstack;
+        }
+        else
+        {
+            pgfree(ppcb->kstack);
+        }
+        ppcb->kstack = NULL;
+    }
+
     switch (ppcb->state)
     {
     case PRCURR:
@@ -33,6 +68,7 @@ syscall kill(int pid)
         // The process should never run this line after resched is called.
         break;
     case PRREADY:
+    case PRWAIT:
         remove(pid);
         ppcb->state = PRFREE;
         break;
@@ -41,5 +77,6 @@ syscall kill(int pid)
         break;
     }
 
+    restore(im);
     return OK;
 }
\ No newline at end of file
@@ -12,20 +12,23 @@
 static unsigned char ungetArray[UNGETMAX];
 unsigned int  bufp = 0;
 
+/**
+ * User processes run on stacks above ::USERHEAPADDR, and the kernel never
+ * does.  The console rings are read-only in user mode, so a user process
+ * goes through a system call instead.
+ */
+#define inuser()  ((ulong)__builtin_frame_address(0) >= USERHEAPADDR)
+
 syscall kgetc()
 {
-    volatile struct ns16550_uart_csreg *regptr;
-    regptr = (struct ns16550_uart_csreg *)UART_BASE;
+    if (inuser())
+        return user_getc(0);
 
     //checks the unget buffer for a character and returns it if there is one.
     if (bufp > 0)
         return ungetArray[--bufp];
-    int val = 0;
-    //check UART line status register, and once there is data ready, gets character c and returns a pointer to it.
-    do {
-        val = regptr->lsr;
-    } while((val & UART_LSR_DR) == 0);
-    return regptr->rbr;
+    // waits for the UART interrupt, see uart.c
+    return uartgetc();
 }
 
 /**
@@ -34,11 +37,8 @@ syscall kgetc()
  */
 syscall kcheckc(void)
 {
-    volatile struct ns16550_uart_csreg *regptr;
-    regptr = (struct ns16550_uart_csreg *)UART_BASE;
-
-    //checks if there is a char in the UART line status register or the buffer and returns true or false accordingly 
-    if((regptr->lsr & UART_LSR_DR) || (bufp > 0))
+    //checks if there is a char in the receive ring or the buffer and returns true or false accordingly 
+    if(uartcanread() || (bufp > 0))
         return 1;
     else
         return 0;
@@ -63,25 +63,71 @@ syscall kungetc(unsigned char c)
 
 syscall kputc(uchar c)
 {
-    volatile struct ns16550_uart_csreg *regptr;
-    regptr = (struct ns16550_uart_csreg *)UART_BASE;
-
-    //checks the UART line status register, Once the Transmitter FIFO is empty, returns character c.
-    int val = 0;
-    do {
-        val = regptr->lsr;
-    } while ((val & UART_LSR_THRE) == 0);
-    regptr->thr = c;
+    if (inuser())
+        return user_putc(0, c);
+
+    //queues character c for the UART interrupt and returns it, see uart.c
+    return uartputc(c);
+}
+
+/**
+ * kwrite - write a run of characters to the console in one go.
+ * @param buf characters to write
+ * @param len how many
+ * @return len
+ */
+syscall kwrite(const uchar *buf, uint len)
+{
+    uint i;
+
+    if (inuser())
+    {
+        for (i = 0; i < len; i++)
+            user_putc(0, buf[i]);
+        return len;
+    }
+
+    //hands the whole run to the UART driver, see uart.c
+    return uartwrite(buf, len);
+}
+
+#define KPRINTF_CHUNK 128       /* characters kprintf() writes at once */
+
+struct kprintfbuf
+{
+    uint len;
+    uchar buf[KPRINTF_CHUNK];
+};
+
+/**
+ * Output function for _doprnt(): collects characters for kwrite().
+ * @param c   character to add
+ * @param arg the kprintfbuf
+ */
+static int kprintfputc(long c, long arg)
+{
+    struct kprintfbuf *kb = (struct kprintfbuf *)arg;
+
+    kb->buf[kb->len++] = c;
+    if (KPRINTF_CHUNK == kb->len)
+    {
+        kwrite(kb->buf, kb->len);
+        kb->len = 0;
+    }
     return c;
 }
 
 syscall kprintf(const char *format, ...)
 {
+    struct kprintfbuf kb;
     int retval;
     va_list ap;
 
+    kb.len = 0;
     va_start(ap, format);
-    retval = _doprnt(format, ap, (int (*)(long, long))kputc, 0);
+    retval = _doprnt(format, ap, kprintfputc, (long)&kb);
     va_end(ap);
+    if (kb.len > 0)
+        kwrite(kb.buf, kb.len);
     return retval;
 }
@@ -0,0 +1,373 @@
+/**
+ * @file ktimer.c
+ * @provides ktimerinit, ktimer_init, ktimer_arm, ktimer_cancel, ktimer_expire, ktimerstat
+ *
+ * Kernel timers on a hierarchical timing wheel (see ktimer.h).  Arming
+ * and cancelling only link or unlink a timer, and an occupancy bitmap per
+ * level finds the next slot with anything in it, so the cost of a clock
+ * interrupt does not grow with the number of pending timers.  Timers in
+ * the upper levels move down a level ("cascade") when the wheel reaches
+ * their slot.  The clock is armed as a one-shot for the next deadline or
+ * cascade, whichever is first.
+ */
+/* Embedded Xinu, Copyright (C) 2024.  All rights reserved. */
+
+#include <xinu.h>
+
+static struct ktimer *twslot[TW_LEVELS][TW_SLOTS];
+static ulong twmap[TW_LEVELS];          /* nonempty slots of each level  */
+static struct ktimer *twfar;            /* beyond the top level          */
+static ulong twnow;                     /* granule the wheel has reached */
+static ulong twperus;                   /* time counts per microsecond   */
+static ulong twfired;                   /* timers expired                */
+static ulong twcascades;                /* timers moved down a level     */
+
+static void twinsert(struct ktimer *t);
+static void twunlink(struct ktimer *t);
+
+/**
+ * Initializes the timer wheel.  Called by clkinit(), once platform.clkfreq
+ * is known.
+ */
+void ktimerinit(void)
+{
+    bzero(twslot, sizeof(twslot));
+    bzero(twmap, sizeof(twmap));
+    twfar = NULL;
+    twnow = rdtime() >> TW_GRAN;
+    twperus = platform.clkfreq / 1000000;
+    twfired = 0;
+    twcascades = 0;
+}
+
+/**
+ * Sets up a timer before its first use.
+ * @param t    the timer
+ * @param func function to call when it expires
+ * @param arg  second argument to func
+ */
+void ktimer_init(struct ktimer *t, ktimerfn func, void *arg)
+{
+    t->next = NULL;
+    t->pprev = NULL;
+    t->when = 0;
+    t->period = 0;
+    t->slot = 0;
+    t->func = func;
+    t->arg = arg;
+}
+
+/**
+ * Arms a timer, re-arming it if it is already pending.
+ * @param t      the timer
+ * @param delay  microseconds from now to the first expiry
+ * @param period microseconds between later expiries, or 0 for one
+ * @return OK, or SYSERR if the timer has no function
+ */
+syscall ktimer_arm(struct ktimer *t, ulong delay, ulong period)
+{
+    irqmask im;
+
+    if (NULL == t || NULL == t->func)
+    {
+        return SYSERR;
+    }
+
+    im = disable();
+    if (ktimer_pending(t))
+        twunlink(t);
+    t->when = rdtime() + delay * twperus;
+    t->period = period * twperus;
+    twinsert(t);
+
+    // Fire early rather than late; ktimer_expire() works out the rest
+    if (t->when < clkdeadline)
+        clkarm(t->when);
+    restore(im);
+
+    return OK;
+}
+
+/**
+ * Cancels a timer.  Once this returns the function will not be called,
+ * unless it is already running.
+ * @param t the timer
+ * @return OK, or SYSERR if the timer was not pending
+ */
+syscall ktimer_cancel(struct ktimer *t)
+{
+    irqmask im;
+
+    im = disable();
+    if (NULL == t || !ktimer_pending(t))
+    {
+        restore(im);
+        return SYSERR;
+    }
+    twunlink(t);
+    restore(im);
+
+    return OK;
+}
+
+/**
+ * @return the index of the lowest set bit of a nonzero word
+ */
+static uint twffs(ulong x)
+{
+    uint n = 0;
+
+    if (0 == (x & 0xFFFFFFFFUL))
+    {
+        n += 32;
+        x >>= 32;
+    }
+    if (0 == (x & 0xFFFF))
+    {
+        n += 16;
+        x >>= 16;
+    }
+    if (0 == (x & 0xFF))
+    {
+        n += 8;
+        x >>= 8;
+    }
+    if (0 == (x & 0xF))
+    {
+        n += 4;
+        x >>= 4;
+    }
+    if (0 == (x & 0x3))
+    {
+        n += 2;
+        x >>= 2;
+    }
+    if (0 == (x & 0x1))
+        n++;
+    return n;
+}
+
+/**
+ * Links a timer into the slot for its deadline.  A deadline the wheel
+ * has already passed goes in the current level 0 slot.
+ */
+static void twinsert(struct ktimer *t)
+{
+    struct ktimer **head;
+    ulong g = t->when >> TW_GRAN;
+    uint l, s;
+
+    if (g < twnow)
+        g = twnow;
+
+    // The lowest level whose block holds both now and the deadline
+    for (l = 0; l < TW_LEVELS; l++)
+    {
+        if (0 == ((g ^ twnow) >> (TW_BITS * (l + 1))))
+            break;
+    }
+
+    if (TW_LEVELS == l)
+    {
+        head = &twfar;
+        t->slot = TW_FAR;
+    }
+    else
+    {
+        s = (g >> (TW_BITS * l)) & TW_MASK;
+        head = &twslot[l][s];
+        twmap[l] |= 1UL << s;
+        t->slot = l * TW_SLOTS + s;
+    }
+
+    t->next = *head;
+    if (t->next != NULL)
+        t->next->pprev = &t->next;
+    t->pprev = head;
+    *head = t;
+}
+
+/**
+ * Unlinks a pending timer.
+ */
+static void twunlink(struct ktimer *t)
+{
+    uint l, s;
+
+    *t->pprev = t->next;
+    if (t->next != NULL)
+        t->next->pprev = t->pprev;
+    t->next = NULL;
+    t->pprev = NULL;
+
+    if (t->slot != TW_FAR)
+    {
+        l = t->slot / TW_SLOTS;
+        s = t->slot % TW_SLOTS;
+        if (NULL == twslot[l][s])
+            twmap[l] &= ~(1UL << s);
+    }
+}
+
+/**
+ * Finds the next granule at which the wheel has work: the first nonempty
+ * slot of the lowest level that has one.  Any such slot comes before
+ * every slot of the levels above it.
+ * @param level where the level of that slot is stored
+ * @return the granule, or TW_NEVER if no timer is pending
+ */
+static ulong twnext(uint *level)
+{
+    ulong map, block;
+    uint l, cur;
+
+    for (l = 0; l < TW_LEVELS; l++)
+    {
+        cur = (twnow >> (TW_BITS * l)) & TW_MASK;
+        map = twmap[l] & (~0UL << cur);
+        if (map != 0)
+        {
+            *level = l;
+            block = (twnow >> (TW_BITS * (l + 1))) << (TW_BITS * (l + 1));
+            return block | ((ulong)twffs(map) << (TW_BITS * l));
+        }
+    }
+
+    // The far list comes back when the top level starts over
+    *level = TW_LEVELS;
+    if (twfar != NULL)
+        return ((twnow >> (TW_BITS * TW_LEVELS)) + 1) << (TW_BITS * TW_LEVELS);
+    return TW_NEVER;
+}
+
+/**
+ * Moves the wheel to granule g, cascading the slots it reaches in the
+ * upper levels, highest first, so their timers drop to the levels below.
+ */
+static void twadvance(ulong g)
+{
+    struct ktimer *t, *list;
+    int l;
+
+    twnow = g;
+    for (l = TW_LEVELS; l >= 1; l--)
+    {
+        if ((g & ((1UL << (TW_BITS * l)) - 1)) != 0)
+            continue;
+
+        if (TW_LEVELS == l)
+        {
+            list = twfar;
+            twfar = NULL;
+        }
+        else
+        {
+            list = twslot[l][(g >> (TW_BITS * l)) & TW_MASK];
+            twslot[l][(g >> (TW_BITS * l)) & TW_MASK] = NULL;
+            twmap[l] &= ~(1UL << ((g >> (TW_BITS * l)) & TW_MASK));
+        }
+
+        while (list != NULL)
+        {
+            t = list;
+            list = t->next;
+            twinsert(t);
+            twcascades++;
+        }
+    }
+}
+
+/**
+ * Runs the timers that are due and arms the clock for the next deadline.
+ * Called by the clock interrupt handler, with interrupts off.  Timers
+ * fire one at a time in deadline order, and the wheel is looked at afresh
+ * after each, since a function may arm or cancel others.
+ */
+void ktimer_expire(void)
+{
+    struct ktimer *t, *first;
+    ulong g, now, when;
+    uint level;
+
+    while (1)
+    {
+        now = rdtime();
+        g = twnext(&level);
+        if (TW_NEVER == g)
+        {
+            clkarm(TW_NEVER);
+            return;
+        }
+
+        // Level 0 holds whole deadlines; an upper level only a cascade
+        first = NULL;
+        if (0 == level)
+        {
+            for (t = twslot[0][g & TW_MASK]; t != NULL; t = t->next)
+            {
+                if (NULL == first || t->when < first->when)
+                    first = t;
+            }
+            when = first->when;
+        }
+        else
+        {
+            when = g << TW_GRAN;
+        }
+
+        if (when > now)
+        {
+            clkarm(when);
+            return;
+        }
+
+        if (g > twnow || level != 0)
+            twadvance(g);
+        if (NULL == first)
+            continue;
+
+        twunlink(first);
+        if (first->period != 0)
+        {
+            // Keep to the original beat, skipping beats already missed
+            first->when += first->period;
+            if (first->when <= now)
+                first->when += ((now - first->when) / first->period + 1)
+                    * first->period;
+            twinsert(first);
+        }
+        twfired++;
+        (*first->func) (first, first->arg);
+    }
+}
+
+/**
+ * Prints the state of the timer wheel.
+ */
+void ktimerstat(void)
+{
+    struct ktimer *t;
+    ulong n;
+    uint l, s;
+    irqmask im;
+
+    im = disable();
+    kprintf("level   pending\r\n");
+    for (l = 0; l < TW_LEVELS; l++)
+    {
+        n = 0;
+        for (s = 0; s < TW_SLOTS; s++)
+        {
+            for (t = twslot[l][s]; t != NULL; t = t->next)
+                n++;
+        }
+        kprintf("%5u %9lu\r\n", l, n);
+    }
+    for (n = 0, t = twfar; t != NULL; t = t->next)
+        n++;
+    kprintf("  far %9lu\r\n", n);
+    kprintf("%lu fired, %lu cascaded, next deadline %lu counts away\r\n",
+            twfired, twcascades,
+            (TW_NEVER == clkdeadline) ? 0 : clkdeadline - rdtime());
+    restore(im);
+}
@@ -0,0 +1,76 @@
+/**
+ * @file ktrace.c
+ * @provides ktrace_reset, ktracedump
+ *
+ * Kernel trace buffer (see ktrace.h).  Tracepoints write fixed-size
+ * binary events into a ring in kernel memory; nothing is formatted or
+ * printed until ktracedump() sends the ring over the console, so tracing
+ * a hot path costs a few stores rather than a kprintf().
+ */
+/* Embedded Xinu, Copyright (C) 2024.  All rights reserved. */
+
+#include <xinu.h>
+
+#if KTRACE
+struct ktevent ktracebuf[KTRACE_LEN];
+ulong ktraceidx = 0;
+bool ktraceon = TRUE;
+
+static ulong ktcycles0, kttime0;        /* clocks at the last reset      */
+#endif
+
+/**
+ * Empties the trace buffer and starts tracing.
+ */
+void ktrace_reset(void)
+{
+#if KTRACE
+    irqmask im;
+
+    im = disable();
+    ktraceidx = 0;
+    ktcycles0 = clk_cycles();
+    kttime0 = rdtime();
+    ktraceon = TRUE;
+    restore(im);
+#endif
+}
+
+/**
+ * Stops tracing and sends the buffer over the console: a struct ktheader,
+ * then the events it counts, oldest first, as raw little-endian binary.
+ * Capture the console to a file and run compile/ktrace2json.py on it.
+ */
+void ktracedump(void)
+{
+#if KTRACE
+    struct ktheader hdr;
+    ulong first;
+
+    ktraceon = FALSE;
+
+    hdr.magic = KTRACE_MAGIC;
+    hdr.version = KTRACE_VERSION;
+    hdr.count = (ktraceidx < KTRACE_LEN) ? ktraceidx : KTRACE_LEN;
+    hdr.lost = ktraceidx - hdr.count;
+    hdr.clkfreq = platform.clkfreq;
+    hdr.cycles0 = ktcycles0;
+    hdr.time0 = kttime0;
+    hdr.cycles1 = clk_cycles();
+    hdr.time1 = rdtime();
+
+    // Straight out by polling, so the dump does not queue behind itself
+    uartpoll(TRUE);
+    kwrite((uchar *)&hdr, sizeof(hdr));
+    first = ktraceidx - hdr.count;
+    while (first < ktraceidx)
+    {
+        kwrite((uchar *)&ktracebuf[first & (KTRACE_LEN - 1)],
+               sizeof(struct ktevent));
+        first++;
+    }
+    uartpoll(FALSE);
+#else
+    kprintf("ktracedump: built without KTRACE\r\n");
+#endif
+}
@@ -8,7 +8,12 @@
 
 #include <xinu.h>
 
-static ulong *pgTraverseAndCreate(pgtbl pagetable, ulong virtualaddr, int attr, ulong physicaladdr);
+static pgtbl pgTraverseAndCreate(pgtbl pagetable, ulong virtualaddr);
+static int pgRangeUpdate(pgtbl pagetable, ulong virtualaddr, ulong length, int attr, bool unmap);
+static bool pgTableEmpty(pgtbl table);
+
+/* Index of the entry for an address in the table at a level (2 is the root) */
+#define VPN(va, level)  (((va) >> (12 + 9 * (level))) & 0x1FF)
 
 /**
  * Maps a page to a specific virtual address
@@ -20,20 +25,15 @@ static ulong *pgTraverseAndCreate(pgtbl pagetable, ulong virtualaddr, int attr,
  */
 syscall mapPage(pgtbl pagetable, page pg, ulong virtualaddr, int attr, ulong physicaladdr)
 {
-    ulong addr;
-
-    addr = (ulong)truncpage(virtualaddr);
-
-    if (pgTraverseAndCreate(pagetable, addr, attr, physicaladdr) == (ulong *)SYSERR)
-    {
-        return SYSERR;
-    }
-
-    return OK;
+    return mapAddress(pagetable, virtualaddr, physicaladdr, PAGE_SIZE, attr);
 }
 
 /**
  * Maps a given virtual address range to a corresponding physical address range.
+ * The tables are descended once for each level 0 table the range touches,
+ * and the consecutive entries in it are then filled in directly.  If a
+ * table cannot be allocated, everything this call mapped is taken back.
+ * RAM is mapped cached and anything below it as an uncached device.
  * @param pagetable    the base pagetable
  * @param virtualaddr  the start of the virtual address range. This will be truncated to the nearest page boundry.
  * @param physicaladdr the start of the physical address range
@@ -44,9 +44,11 @@ syscall mapPage(pgtbl pagetable, page pg, ulong virtualaddr, int attr, ulong phy
 syscall mapAddress(pgtbl pagetable, ulong virtualaddr, ulong physicaladdr,
                ulong length, int attr)
 {
-    ulong addr, end;
-    ulong nlength;
-
+    ulong start, addr, end;
+    pgtbl lvl0tbl;
+    struct frame *fr;
+    uint k;
+    irqmask im;
 
     if (length == 0)
     {
@@ -54,70 +56,297 @@ syscall mapAddress(pgtbl pagetable, ulong virtualaddr, ulong physicaladdr,
     }
 
     // Round the length to the nearest page size
-    nlength = roundpage(length);
-    addr = (ulong)truncpage(virtualaddr);
-    end = addr + nlength;
+    start = addr = (ulong)truncpage(virtualaddr);
+    end = addr + roundpage(length);
 
-    // Loop over the entire range
-    for (; addr < end; addr += PAGE_SIZE, physicaladdr += PAGE_SIZE)
+    while (addr < end)
     {
-        // Create a page table entry if one doesn't exist. Otherwise, get the existing page table entry.
-        if (pgTraverseAndCreate(pagetable, addr, attr, physicaladdr) == (ulong *)SYSERR)
+        lvl0tbl = pgTraverseAndCreate(pagetable, addr);
+        if ((pgtbl)SYSERR == lvl0tbl)
         {
+            if (addr > start)
+                unmapAddress(pagetable, start, addr - start);
             return SYSERR;
         }
+
+        // Fill the rest of this level 0 table without walking again
+        for (k = VPN(addr, 0); k < PTE_PER_TBL && addr < end;
+             k++, addr += PAGE_SIZE, physicaladdr += PAGE_SIZE)
+        {
+            lvl0tbl[k] = PA2PTE(physicaladdr) | attr | PTE_V
+                | ((physicaladdr >= DRAM_BASE) ? PTE_MEM : PTE_IO);
+
+            // A user mapping of a managed frame holds its own reference
+            if ((attr & PTE_U) && PG_MANAGED(physicaladdr))
+            {
+                im = disable();
+                fr = PG_FRAME(physicaladdr);
+                fr->mapcount++;
+                fr->flags |= FR_USER;
+                pgref((void *)physicaladdr);
+                restore(im);
+            }
+        }
     }
 
     return OK;
 }
 
 /**
- * Starting at the base pagetable, tranverse the hierarchical page table structure for the virtual address.  Create pages along the way if they don't exist.
+ * Finds the leaf page table entry for a virtual address without creating
+ * any tables.
  * @param pagetable    the base pagetable
- * @param virtualaddr  the virtual address to find the it's corresponding page table entry.
- * @param attr	       the attributes to set on the leaf page
- * @return             OK
+ * @param virtualaddr  the virtual address to look up
+ * @return             the level 0 entry, which may be invalid, or NULL if
+ *                     no level 0 table covers the address
  */
-static ulong *pgTraverseAndCreate(pgtbl pagetable, ulong virtualaddr, int attr, ulong physicaladdr)
+ulong *pgLookup(pgtbl pagetable, ulong virtualaddr)
 {
-    /**
-    * TODO:
-    * For each level in the page table, get the page table entry by masking and shifting the bits in the virtualaddr depending on the level
-    * If the valid bit is set, use that pagetable for the next level
-    * Otherwise create the page by calling pgalloc().  Make sure to setup the page table entry accordingly. Call sfence_vma once finished to flush TLB
-    * Once you've tranversed all three levels, set the attributes (attr) for the leaf page (don't forget to set the valid bit!)
-    */
-
-   ulong VA2 = virtualaddr >> 30 & 0x1FF; 
-   ulong VA1 = ((virtualaddr << 9) >> 30 & 0x1FF);
-   ulong VA0 = ((virtualaddr << 18 ) >> 30 & 0x1FF);
-
-    pgtbl lvl1tbl;
-    pgtbl lvl0tbl;
-    if(pagetable[VA2] & PTE_V){
-        lvl1tbl = PTE2PA(pagetable[VA2]);
-        if(lvl1tbl[VA1] & PTE_V){
-            lvl0tbl = PTE2PA(lvl1tbl[VA1]);
+    pgtbl tbl = pagetable;
+    ulong pte;
+    int level;
+
+    for (level = 2; level > 0; level--)
+    {
+        pte = tbl[(virtualaddr >> (12 + 9 * level)) & 0x1FF];
+        if (!(pte & PTE_V) || (pte & PTE_LEAF))
+            return NULL;
+        tbl = (pgtbl)PTE2PA(pte);
+    }
+
+    return &tbl[(virtualaddr >> 12) & 0x1FF];
+}
+
+/**
+ * Removes the mappings in a virtual address range.  Each user mapping of
+ * a managed frame gives up the reference it holds, and level 0 and
+ * level 1 tables left empty are freed (except in ::_userpgtbl, whose
+ * tables every user root points at).
+ * @param pagetable    the base pagetable
+ * @param virtualaddr  the start of the range, truncated to a page boundary
+ * @param length       the length of the range
+ * @return             OK, or SYSERR if the range is empty or reaches into
+ *                     the kernel half a user pagetable shares
+ */
+syscall unmapAddress(pgtbl pagetable, ulong virtualaddr, ulong length)
+{
+    return pgRangeUpdate(pagetable, virtualaddr, length, 0, TRUE);
+}
+
+/**
+ * Changes the permissions of the mappings in a virtual address range.
+ * Unmapped pages in the range are left alone, and a copy-on-write page
+ * stays read-only until its fault is taken.
+ * @param pagetable    the base pagetable
+ * @param virtualaddr  the start of the range, truncated to a page boundary
+ * @param length       the length of the range
+ * @param attr         the new PTE_R, PTE_W and PTE_X bits
+ * @return             OK, or SYSERR if attr is not a valid leaf
+ *                     permission or the range is bad as for unmapAddress()
+ */
+syscall protectAddress(pgtbl pagetable, ulong virtualaddr, ulong length, int attr)
+{
+    // Write-only is reserved, and no permission at all would be a table
+    if ((attr & ~PTE_LEAF) || 0 == attr || PTE_W == (attr & (PTE_R | PTE_W)))
+    {
+        return SYSERR;
+    }
+
+    return pgRangeUpdate(pagetable, virtualaddr, length, attr, FALSE);
+}
+
+/**
+ * Starting at the base pagetable, finds the level 0 table that covers a
+ * virtual address, allocating the level 1 and level 0 tables on the way
+ * if they don't exist.  New tables belong to the owner of the root.
+ * @param pagetable    the base pagetable
+ * @param virtualaddr  the virtual address
+ * @return             the level 0 table, or SYSERR if a table could not be
+ *                     allocated or a superpage is in the way
+ */
+static pgtbl pgTraverseAndCreate(pgtbl pagetable, ulong virtualaddr)
+{
+    ulong *pte2 = &pagetable[VPN(virtualaddr, 2)];
+    ulong *pte1;
+    pgtbl lvl1tbl, lvl0tbl;
+    bool newlvl1 = FALSE;
+
+    if (*pte2 & PTE_LEAF)
+    {
+        return (pgtbl)SYSERR;
+    }
+    if (*pte2 & PTE_V)
+    {
+        lvl1tbl = (pgtbl)PTE2PA(*pte2);
+    }
+    else
+    {
+        lvl1tbl = kmcache_alloc(pgtblcache);
+        if ((pgtbl)SYSERR == lvl1tbl)
+            return (pgtbl)SYSERR;
+        PG_FRAME(lvl1tbl)->owner = PG_FRAME(pagetable)->owner;
+        *pte2 = PA2PTE(lvl1tbl) | PTE_V;
+        newlvl1 = TRUE;
+    }
+
+    pte1 = &lvl1tbl[VPN(virtualaddr, 1)];
+    if (*pte1 & PTE_LEAF)
+    {
+        return (pgtbl)SYSERR;
+    }
+    if (*pte1 & PTE_V)
+    {
+        return (pgtbl)PTE2PA(*pte1);
+    }
+
+    lvl0tbl = kmcache_alloc(pgtblcache);
+    if ((pgtbl)SYSERR == lvl0tbl)
+    {
+        // Don't leave an empty level 1 table behind
+        if (newlvl1)
+        {
+            *pte2 = 0;
+            kmcache_free(pgtblcache, lvl1tbl);
         }
-        else{
-            lvl0tbl = pgalloc();
-            lvl1tbl[VA1] = PA2PTE(lvl0tbl);
-            lvl1tbl[VA1] = lvl1tbl[VA1] | PTE_V;
+        return (pgtbl)SYSERR;
+    }
+    PG_FRAME(lvl0tbl)->owner = PG_FRAME(pagetable)->owner;
+    *pte1 = PA2PTE(lvl0tbl) | PTE_V;
+
+    return lvl0tbl;
+}
+
+/**
+ * Unmaps or reprotects a range, descending to each level 0 table once and
+ * then stepping along its entries.  A small range is flushed from the TLB
+ * page by page; a large one, or one that freed a table, flushes the whole
+ * address space once at the end.
+ * @param pagetable    the base pagetable
+ * @param virtualaddr  the start of the range
+ * @param length       the length of the range
+ * @param attr         new permission bits, when not unmapping
+ * @param unmap        TRUE to remove the mappings
+ * @return             OK or SYSERR
+ */
+static int pgRangeUpdate(pgtbl pagetable, ulong virtualaddr, ulong length, int attr, bool unmap)
+{
+    ulong addr, end, asid, pte;
+    pgtbl lvl1tbl, lvl0tbl;
+    struct frame *fr;
+    uint i, j, k;
+    bool perpage, freetables, flushall = FALSE;
+    irqmask im;
+
+    addr = truncpage(virtualaddr);
+    end = addr + roundpage(length + (virtualaddr - addr));
+    if (0 == length || end <= addr || end > MAXVIRTADDR)
+    {
+        return SYSERR;
+    }
+
+    // The kernel half of a user pagetable belongs to every process
+    if (pagetable != _userpgtbl && _userpgtbl != NULL)
+    {
+        for (i = VPN(addr, 2); i <= VPN(end - 1, 2); i++)
+        {
+            if ((pagetable[i] & PTE_V) && pagetable[i] == _userpgtbl[i])
+                return SYSERR;
         }
     }
-    else{
-        lvl1tbl = pgalloc();
-        pagetable[VA2] = PA2PTE(lvl1tbl);
-        pagetable[VA2] = pagetable[VA2] | PTE_V;
-        
-        lvl0tbl = pgalloc();
-        lvl1tbl[VA1] = PA2PTE(lvl0tbl);
-        lvl1tbl[VA1] = lvl1tbl[VA1] | PTE_V;
+
+    // Every user root points at the template's tables, so keep those
+    freetables = unmap && (pagetable != _userpgtbl);
+
+    asid = PGTBL_ASID(pagetable);
+    perpage = (pagetable != _userpgtbl)
+        && ((end - addr) / PAGE_SIZE <= PG_FLUSHPAGES);
+
+    while (addr < end)
+    {
+        i = VPN(addr, 2);
+        if (!(pagetable[i] & PTE_V) || (pagetable[i] & PTE_LEAF))
+        {
+            addr = (addr | ((1UL << 30) - 1)) + 1;
+            continue;
+        }
+        lvl1tbl = (pgtbl)PTE2PA(pagetable[i]);
+
+        for (j = VPN(addr, 1); addr < end && j < PTE_PER_TBL; j++)
+        {
+            if (!(lvl1tbl[j] & PTE_V) || (lvl1tbl[j] & PTE_LEAF))
+            {
+                addr = (addr | ((1UL << 21) - 1)) + 1;
+                continue;
+            }
+            lvl0tbl = (pgtbl)PTE2PA(lvl1tbl[j]);
+
+            for (k = VPN(addr, 0); addr < end && k < PTE_PER_TBL; k++, addr += PAGE_SIZE)
+            {
+                pte = lvl0tbl[k];
+                if (!(pte & PTE_V))
+                    continue;
+
+                if (unmap)
+                {
+                    lvl0tbl[k] = 0;
+                    if ((pte & PTE_U) && PG_MANAGED(PTE2PA(pte)))
+                    {
+                        im = disable();
+                        fr = PG_FRAME(PTE2PA(pte));
+                        if (fr->mapcount > 0 && 0 == --fr->mapcount)
+                            fr->flags &= ~FR_USER;
+                        pgfree((void *)PTE2PA(pte));
+                        restore(im);
+                    }
+                }
+                else
+                {
+                    lvl0tbl[k] = (pte & ~PTE_LEAF) | attr;
+                    if (pte & PTE_COW)
+                        lvl0tbl[k] &= ~PTE_W;
+                }
+
+                // Global entries survive an address space flush
+                if (pte & PTE_G)
+                    flushall = TRUE;
+                else if (perpage)
+                    sfence_vma_page(addr, asid);
+            }
+
+            if (freetables && pgTableEmpty(lvl0tbl))
+            {
+                lvl1tbl[j] = 0;
+                kmcache_free(pgtblcache, lvl0tbl);
+                perpage = FALSE;
+            }
+        }
+
+        if (freetables && pgTableEmpty(lvl1tbl))
+        {
+            pagetable[i] = 0;
+            kmcache_free(pgtblcache, lvl1tbl);
+        }
     }
-    lvl0tbl[VA0] = PA2PTE(physicaladdr);
-    lvl0tbl[VA0] = lvl0tbl[VA0] | attr | PTE_V;
-   
 
-    return (ulong *)OK;
+    if (flushall || pagetable == _userpgtbl)
+        sfence_vma();
+    else if (!perpage)
+        sfence_vma_asid(asid);
+
+    return OK;
 }
 
+/**
+ * @return TRUE if no entry of the table is valid
+ */
+static bool pgTableEmpty(pgtbl table)
+{
+    uint i;
+
+    for (i = 0; i < PTE_PER_TBL; i++)
+    {
+        if (table[i] & PTE_V)
+            return FALSE;
+    }
+    return TRUE;
+}
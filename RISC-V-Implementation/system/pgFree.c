@@ -1,44 +1,245 @@
 #include <xinu.h>
 
+static void pgrelease(ulong pa, uint order);
+
 /**
- * Puts a range of memory into the physical page list.
+ * Puts a range of memory into the physical page list.  The range is only
+ * recorded as a free extent; pgcarve() splits it into buddy blocks when
+ * an allocation needs them, so neither the frames nor their frame table
+ * entries are touched here.
  * @param start the start address which will be rounded to the nearest page
  * @param end the ending address
  * @return OK if the entire range was able to be freed. SYSERR if an error occurs.
  */
 syscall pgfreerange(void *start, void *end)
 {
-    if (end > platform.maxaddr || (char *)start < (char *)memheap
-        || (char *)end < (char *)start)
+    ulong pa, top;
+
+    pa = roundpage(start);
+    top = truncpage(end);
+
+    if (top > pgend || pa < pgbase || (char *)end < (char *)start)
     {
         return SYSERR;
     }
-
-    char *pgstart = (char *)roundpage(start);
-    for (; pgstart + PAGE_SIZE < (char *)end; pgstart += PAGE_SIZE)
+    if (pa >= top)
+    {
+        return OK;
+    }
+    if (pgnextent >= PG_NEXTENT)
     {
-        if (SYSERR == pgfree(pgstart))
-            return SYSERR;
+        return SYSERR;
     }
 
+    pgextent[pgnextent].base = pa;
+    pgextent[pgnextent].end = top;
+    pgnextent++;
+
     return OK;
 }
 
 /**
- * Frees a single page
+ * Moves free extents onto the buddy lists one block at a time, until a
+ * block of at least the given order has been added.  Each block is the
+ * largest naturally aligned one at the front of an extent, and only its
+ * own frame table entries are set up.
+ * @param order the order of the block that is needed
+ * @return OK, or SYSERR if the extents ran out first
+ */
+syscall pgcarve(uint order)
+{
+    struct pgextent *ext;
+    struct frame *fr;
+    ulong pa, i;
+    uint k;
+
+    while (pgnextent > 0)
+    {
+        ext = &pgextent[pgnextent - 1];
+        pa = ext->base;
+
+        /* Largest block that is aligned at pa and still fits the extent */
+        k = PG_MAXORDER;
+        while (k > 0 && ((pa & (PG_BLKSIZE(k) - 1))
+                         || pa + PG_BLKSIZE(k) > ext->end))
+        {
+            k--;
+        }
+
+        ext->base += PG_BLKSIZE(k);
+        if (ext->base == ext->end)
+            pgnextent--;
+
+        fr = PG_FRAME(pa);
+        for (i = 0; i < ((ulong)1 << k); i++)
+        {
+            fr[i].refcount = 0;
+            fr[i].mapcount = 0;
+            fr[i].flags = 0;
+            fr[i].order = PG_NOTFREE;
+            fr[i].owner = BADPID;
+        }
+        pgrelease(pa, k);
+
+        if (k >= order)
+            return OK;
+    }
+
+    return SYSERR;
+}
+
+/**
+ * Frees a single page, or drops one reference to it if it is shared.
  * @param addr the address to put into the physical page list.  Must be at a page boundry
  * @return SYSERR if the address is not a page boundry. OK otherwise.
  */
 syscall pgfree(void *addr)
 {
-    struct pgmemblk *page;
+    return pgfree_order(addr, 0);
+}
+
+/**
+ * Frees a block of 2^order contiguous pages, merging it with its buddy
+ * for as long as the buddy is also free.  If the block has other
+ * references (see pgref()) only the reference count drops.
+ * @param addr  the first address of the block.  Must be aligned to the block size
+ * @param order the order the block was allocated with
+ * @return SYSERR if the block is misaligned, out of range or already free. OK otherwise.
+ */
+syscall pgfree_order(void *addr, uint order)
+{
+    ulong pa = (ulong)addr;
+    struct frame *fr;
+    ulong i;
+    irqmask im;
+
+    if (order > PG_MAXORDER || (pa & (PG_BLKSIZE(order) - 1)) != 0)
+        return SYSERR;
+
+    if (pa < pgbase || pa + PG_BLKSIZE(order) > pgend || !pgcarved(pa))
+        return SYSERR;
+
+    /* Every allocated block holds at least one reference */
+    im = disable();
+    fr = PG_FRAME(pa);
+    if (0 == fr->refcount)
+    {
+        restore(im);
+        return SYSERR;
+    }
+
+    if (--fr->refcount > 0)
+    {
+        restore(im);
+        return OK;
+    }
+
+    for (i = 0; i < ((ulong)1 << order); i++)
+    {
+        fr[i].mapcount = 0;
+        fr[i].flags = 0;
+        fr[i].owner = BADPID;
+    }
+
+    pgrelease(pa, order);
+    restore(im);
+
+    return OK;
+}
+
+/**
+ * Takes another reference to an allocated frame, so it can be shared by
+ * more than one owner.  Each reference is dropped with pgfree().
+ * @param addr the frame
+ * @return OK, or SYSERR if the frame is not allocated
+ */
+syscall pgref(void *addr)
+{
+    struct frame *fr;
+    irqmask im;
 
-    if ((ulong)addr % PAGE_SIZE != 0)
+    if (!PG_MANAGED(addr) || truncpage(addr) != (ulong)addr)
         return SYSERR;
 
-    page = (struct pgmemblk *)addr;
-    page->next = pgfreelist;
-    pgfreelist = page;
+    im = disable();
+    fr = PG_FRAME(addr);
+    if (!pgcarved((ulong)addr) || 0 == fr->refcount || 0xFFFF == fr->refcount)
+    {
+        restore(im);
+        return SYSERR;
+    }
+
+    fr->refcount++;
+    restore(im);
 
     return OK;
 }
+
+/**
+ * Puts a block on the free lists, merging it with its buddy for as long
+ * as the buddy is also free.
+ * @param pa    the first address of the block
+ * @param order the order of the block
+ */
+static void pgrelease(ulong pa, uint order)
+{
+    ulong buddy;
+
+    while (order < PG_MAXORDER)
+    {
+        buddy = pa ^ PG_BLKSIZE(order);
+        if (buddy < pgbase || buddy + PG_BLKSIZE(order) > pgend
+            || !pgcarved(buddy) || PG_FRAME(buddy)->order != order)
+        {
+            break;
+        }
+
+        /* Buddy is free and the same size, so absorb it */
+        pglistremove((struct pgmemblk *)buddy, order);
+        pa &= ~PG_BLKSIZE(order);
+        order++;
+    }
+
+    pglistadd((struct pgmemblk *)pa, order);
+}
+
+/**
+ * Pushes a free block onto the free list of its order.
+ * @param blk   the free block
+ * @param order the order of the block
+ */
+void pglistadd(struct pgmemblk *blk, uint order)
+{
+    struct pgfreearea *area = &pgfreearea[order];
+
+    blk->prev = NULL;
+    blk->next = area->head;
+    if (area->head != NULL)
+        area->head->prev = blk;
+    area->head = blk;
+    area->nfree++;
+
+    PG_FRAME(blk)->order = order;
+    PG_FRAME(blk)->flags = FR_FREE;
+}
+
+/**
+ * Unlinks a free block from the free list of its order.
+ * @param blk   the free block
+ * @param order the order of the block
+ */
+void pglistremove(struct pgmemblk *blk, uint order)
+{
+    struct pgfreearea *area = &pgfreearea[order];
+
+    if (blk->prev != NULL)
+        blk->prev->next = blk->next;
+    else
+        area->head = blk->next;
+    if (blk->next != NULL)
+        blk->next->prev = blk->prev;
+    area->nfree--;
+
+    PG_FRAME(blk)->order = PG_NOTFREE;
+    PG_FRAME(blk)->flags = 0;
+}
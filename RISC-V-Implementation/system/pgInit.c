@@ -3,13 +3,30 @@
 /**
  * Initialize the physical pages by calling pgfreerange across the entire
  * avaliable memory space.  This should be done before any paging is setup.
+ * The frame metadata array is placed at the bottom of the heap and the
+ * frames above it become one free extent.  Entries of the array are only
+ * set up as pgcarve() hands their frames to the free lists, so this costs
+ * the same however much memory there is.
  */
 void pgInit(void)
 {
+    uint k;
+
     /* number of pages in memory */
     pgtbl_nents =
         roundpage((ulong)platform.maxaddr - (ulong)memheap) / PAGE_SIZE;
 
-    pgfreerange(memheap, platform.maxaddr);
-}
+    /* one struct frame per page, then the managed frames */
+    frametab = (struct frame *)memheap;
+    pgbase = roundpage((ulong)memheap + pgtbl_nents * sizeof(struct frame));
+    pgend = truncpage(platform.maxaddr);
 
+    for (k = 0; k <= PG_MAXORDER; k++)
+    {
+        pgfreearea[k].head = NULL;
+        pgfreearea[k].nfree = 0;
+    }
+    pgnextent = 0;
+
+    pgfreerange((void *)pgbase, (void *)pgend);
+}
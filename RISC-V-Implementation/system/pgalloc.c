@@ -1,30 +1,235 @@
 /**
  * @file pgalloc
- * Gets a single free physical page
+ * Gets free physical pages from the buddy allocator
  *
  */
 /* Embedded Xinu, Copyright (C) 2023.  All rights reserved. */
 
 #include <xinu.h>
 
+static void *pgtake(uint order);
+static void pgclaim(void *blk, uint order);
+
 /**
- * Gets a single free physical page.
+ * Gets a single free physical page, cleared to zero.  Frames zeroed ahead
+ * of time by the null process are used first; otherwise the clearing is
+ * done here.
  * @return the address of the page or if there are no more pages avaliable, a SYSERR.
  */
 void *pgalloc(void)
 {
     struct pgmemblk *page;
+    irqmask im;
 
-    if (pgfreelist == NULL)
+    im = disable();
+    if (pgzerolist != NULL)
+    {
+        page = pgzerolist;
+        pgzerolist = page->next;
+        pgzerocount--;
+        page->next = NULL;      /* the only non-zero word in the frame */
+        pgclaim(page, 0);
+        restore(im);
+        return (void *)page;
+    }
+    restore(im);
+
+    page = pgalloc_nozero();
+    if ((void *)SYSERR == page)
     {
         return (void *)SYSERR;
     }
 
-    page = pgfreelist;
-    pgfreelist = page->next;
+    // Clears the data in the page, with interrupts on
+    pgclear(page);
+
+    return (void *)page;
+}
+
+/**
+ * Gets a single free physical page without clearing it, for callers that
+ * overwrite the whole frame anyway.  Dirty frames are preferred so the
+ * zeroed pool is left for pgalloc().
+ * @return the address of the page or if there are no more pages avaliable, a SYSERR.
+ */
+void *pgalloc_nozero(void)
+{
+    struct pgmemblk *page;
+    irqmask im;
+
+    im = disable();
+    page = pgtake(0);
+    if ((void *)SYSERR == page && pgzerolist != NULL)
+    {
+        page = pgzerolist;
+        pgzerolist = page->next;
+        pgzerocount--;
+    }
 
-    // Clears the data in the page
-    bzero((char *)page, PAGE_SIZE);
+    if ((void *)SYSERR != page)
+    {
+        pgclaim(page, 0);
+    }
+    restore(im);
 
     return (void *)page;
-}
\ No newline at end of file
+}
+
+/**
+ * Gets a block of 2^order physically contiguous pages, cleared to zero.
+ * The block is aligned to its own size, so an order 9 block can back a
+ * megapage.
+ * @param order the order of the block to allocate
+ * @return the address of the block or if no block that large is avaliable, a SYSERR.
+ */
+void *pgalloc_order(uint order)
+{
+    void *blk;
+    irqmask im;
+
+    im = disable();
+    blk = pgtake(order);
+    if ((void *)SYSERR == blk && pgzerocount > 0)
+    {
+        // The zeroed pool may be holding the buddies we need
+        pgzerodrain();
+        blk = pgtake(order);
+    }
+
+    if ((void *)SYSERR == blk)
+    {
+        restore(im);
+        return (void *)SYSERR;
+    }
+    pgclaim(blk, order);
+    restore(im);
+
+    // Clears the data in the block
+    bzero((char *)blk, PG_BLKSIZE(order));
+
+    return blk;
+}
+
+/**
+ * Takes a block of 2^order pages from the buddy free lists, splitting a
+ * larger block if needed.  The contents of the block are left as they are.
+ * @param order the order of the block to take
+ * @return the address of the block or SYSERR
+ */
+static void *pgtake(uint order)
+{
+    struct pgmemblk *blk;
+    uint k;
+
+    if (order > PG_MAXORDER)
+    {
+        return (void *)SYSERR;
+    }
+
+    // Find the smallest order that has a free block
+    for (k = order; k <= PG_MAXORDER && pgfreearea[k].head == NULL; k++)
+        ;
+
+    // Otherwise carve more of the free extents into blocks
+    if (k > PG_MAXORDER)
+    {
+        if (SYSERR == pgcarve(order))
+            return (void *)SYSERR;
+        for (k = order; k <= PG_MAXORDER && pgfreearea[k].head == NULL; k++)
+            ;
+    }
+
+    blk = pgfreearea[k].head;
+    pglistremove(blk, k);
+
+    // Split it, handing the upper halves back as free buddies
+    while (k > order)
+    {
+        k--;
+        pglistadd((struct pgmemblk *)((ulong)blk + PG_BLKSIZE(k)), k);
+    }
+
+    return (void *)blk;
+}
+
+/**
+ * Records a newly allocated block in the frame table: one reference,
+ * owned by the current process, for kernel use until someone maps it.
+ * @param blk   the block
+ * @param order the order of the block
+ */
+static void pgclaim(void *blk, uint order)
+{
+    struct frame *fr = PG_FRAME(blk);
+    ulong i;
+
+    ktrace(KT_PGALLOC, (ulong)blk, order);
+    for (i = 0; i < ((ulong)1 << order); i++)
+    {
+        fr[i].refcount = 0;
+        fr[i].mapcount = 0;
+        fr[i].flags = FR_KERNEL;
+        fr[i].owner = currpid;
+    }
+    fr->refcount = 1;
+}
+
+/**
+ * @return the largest order that currently has a free block, or SYSERR
+ *         if physical memory is exhausted.
+ */
+int pglargestorder(void)
+{
+    ulong base;
+    uint i;
+    int k;
+
+    for (k = PG_MAXORDER; k >= 0; k--)
+    {
+        if (pgfreearea[k].head != NULL)
+            return k;
+
+        // A free extent that holds an aligned block of this order
+        for (i = 0; i < pgnextent; i++)
+        {
+            base = (pgextent[i].base + PG_BLKSIZE(k) - 1) & ~(PG_BLKSIZE(k) - 1);
+            if (base + PG_BLKSIZE(k) <= pgextent[i].end)
+                return k;
+        }
+    }
+    return SYSERR;
+}
+
+/**
+ * @return the number of free physical pages, including the zeroed pool
+ *         and the extents not yet carved into blocks
+ */
+ulong pgfreepages(void)
+{
+    ulong n = pgzerocount;
+    uint k;
+
+    for (k = 0; k <= PG_MAXORDER; k++)
+        n += (ulong)pgfreearea[k].nfree << k;
+    for (k = 0; k < pgnextent; k++)
+        n += (pgextent[k].end - pgextent[k].base) / PAGE_SIZE;
+    return n;
+}
+
+/**
+ * Prints the number of free blocks of each order.
+ */
+void pgstat(void)
+{
+    uint k;
+
+    kprintf("order:");
+    for (k = 0; k <= PG_MAXORDER; k++)
+        kprintf(" %5d", k);
+    kprintf("\r\nfree: ");
+    for (k = 0; k <= PG_MAXORDER; k++)
+        kprintf(" %5d", pgfreearea[k].nfree);
+    kprintf("\r\n%lu pages free (%u pre-zeroed, %u uncarved extents), "
+            "largest free order %d\r\n",
+            pgfreepages(), pgzerocount, pgnextent, pglargestorder());
+}
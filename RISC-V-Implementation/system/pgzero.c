@@ -0,0 +1,66 @@
+/**
+ * @file pgzero.c
+ * Pool of physical frames that are cleared ahead of time, so pgalloc()
+ * does not have to clear them in the caller's critical path.
+ */
+/* Embedded Xinu, Copyright (C) 2024.  All rights reserved. */
+
+#include <xinu.h>
+
+/**
+ * Moves dirty frames from the buddy allocator to the zeroed pool, clearing
+ * each one on the way.  Called by the null process when there is nothing
+ * else to run.
+ * @param count the most frames to clear in this call
+ * @return the number of frames added to the pool
+ */
+uint pgzeroidle(uint count)
+{
+    struct pgmemblk *page;
+    uint n;
+    irqmask im;
+
+    for (n = 0; n < count && pgzerocount < PG_ZEROPOOL; n++)
+    {
+        // Only take dirty frames; never recycle the pool into itself
+        if (SYSERR == pglargestorder())
+            break;
+
+        page = pgalloc_nozero();
+        if ((struct pgmemblk *)SYSERR == page)
+            break;
+
+        // Clearing is the long part, and runs with interrupts on
+        pgclear(page);
+
+        im = disable();
+        PG_FRAME(page)->flags = FR_ZEROED;
+        PG_FRAME(page)->owner = BADPID;
+        page->next = pgzerolist;
+        pgzerolist = page;
+        pgzerocount++;
+        restore(im);
+    }
+
+    return n;
+}
+
+/**
+ * Returns every frame in the zeroed pool to the buddy allocator, so they
+ * can be merged into larger blocks again.
+ */
+void pgzerodrain(void)
+{
+    struct pgmemblk *page;
+    irqmask im;
+
+    im = disable();
+    while (pgzerolist != NULL)
+    {
+        page = pgzerolist;
+        pgzerolist = page->next;
+        pgzerocount--;
+        pgfree(page);
+    }
+    restore(im);
+}
@@ -28,7 +28,10 @@ int platforminit(void)
     platform.maxaddr = (void *)0x78FFFFFFUL;
 
     regptr = (struct ns16550_uart_csreg *)UART_BASE;
+    platform.uart_addr = regptr;
+    platform.uart_irqnum = IRQ_UART0;
 
+    // Polled until uartinit() turns the interrupts on
     regptr->ier = 0;
 
     /* Enable UART FIFOs, clear and set interrupt trigger level       */
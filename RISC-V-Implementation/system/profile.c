@@ -0,0 +1,141 @@
+/**
+ * @file profile.c
+ * @provides profsample, profstart, profstop, profdump
+ *
+ * PC-sampling profiler (see profile.h).  A periodic kernel timer keeps
+ * the clock interrupting at the sampling rate, and the clock interrupt
+ * notes where it came in: sepc, whether that was the kernel or a user
+ * process, and which process.  Samples go into a buffer that fills once
+ * per profstart(); nothing is symbolized until the host has the dump.
+ */
+/* Embedded Xinu, Copyright (C) 2024.  All rights reserved. */
+
+#include <xinu.h>
+
+#define PROF_MINPERIOD 10       /* shortest period, in microseconds      */
+
+#if PROFILE
+bool profon = FALSE;
+struct ktimer proftimer;
+
+static struct profsample profbuf[PROF_LEN];
+static uint profcount;                  /* samples taken                 */
+static uint profdropped;                /* samples with no room left     */
+static ulong profperiod;                /* microseconds between samples  */
+
+/**
+ * Takes a sample of the interrupted code.  Called from the clock
+ * interrupt with interrupts still off, so sepc and sstatus.SPP are still
+ * those of the trap.
+ */
+void profsample(void)
+{
+    struct profsample *s;
+
+    if (PROF_LEN == profcount)
+    {
+        profdropped++;
+        return;
+    }
+    s = &profbuf[profcount++];
+    s->pc = get_sepc();
+    s->pid = currpid;
+    s->kernel = (get_sstatus() & SSTATUS_S_MODE) ? 1 : 0;
+}
+
+/**
+ * The profiling timer's function.  The sample is taken by clkhandler()
+ * before this runs, while sepc still holds the interrupted pc.
+ */
+static void proftick(struct ktimer *t, void *arg)
+{
+}
+#endif
+
+/**
+ * Empties the sample buffer and starts sampling.  A shorter period gives
+ * more samples and costs more: each sample is one clock interrupt.
+ * @param period microseconds between samples
+ * @return OK, or SYSERR if the period is too short or profiling is not
+ *         built in
+ */
+syscall profstart(ulong period)
+{
+#if PROFILE
+    irqmask im;
+
+    if (period < PROF_MINPERIOD)
+    {
+        return SYSERR;
+    }
+
+    profstop();
+    im = disable();
+    profcount = 0;
+    profdropped = 0;
+    profperiod = period;
+    ktimer_init(&proftimer, proftick, NULL);
+    ktimer_arm(&proftimer, period, period);
+    profon = TRUE;
+    restore(im);
+
+    return OK;
+#else
+    return SYSERR;
+#endif
+}
+
+/**
+ * Stops sampling, keeping the samples taken so far.
+ */
+void profstop(void)
+{
+#if PROFILE
+    irqmask im;
+
+    im = disable();
+    profon = FALSE;
+    ktimer_cancel(&proftimer);
+    restore(im);
+#endif
+}
+
+/**
+ * Stops sampling and sends the samples over the console: a struct
+ * profheader, the samples in the order they were taken, then the name of
+ * each process slot (empty if free), all as raw little-endian binary.
+ * Capture the console to a file and run compile/profsym.py on it.
+ */
+void profdump(void)
+{
+#if PROFILE
+    struct profheader hdr;
+    char name[PNMLEN];
+    int i;
+
+    profstop();
+
+    hdr.magic = PROF_MAGIC;
+    hdr.version = PROF_VERSION;
+    hdr.count = profcount;
+    hdr.dropped = profdropped;
+    hdr.period = profperiod;
+    hdr.nproc = NPROC;
+    hdr.pnmlen = PNMLEN;
+
+    // Straight out by polling, so the dump does not queue behind itself
+    uartpoll(TRUE);
+    kwrite((uchar *)&hdr, sizeof(hdr));
+    kwrite((uchar *)profbuf, profcount * sizeof(struct profsample));
+    for (i = 0; i < NPROC; i++)
+    {
+        bzero(name, PNMLEN);
+        if (proctab[i].state != PRFREE)
+            strncpy(name, proctab[i].name, PNMLEN);
+        kwrite((uchar *)name, PNMLEN);
+    }
+    uartpoll(FALSE);
+#else
+    kprintf("profdump: built without PROFILE\r\n");
+#endif
+}
@@ -17,8 +17,10 @@
 syscall ready(pid_typ pid, bool resch)
 {
     register pcb *ppcb;
+    irqmask im;
     ASSERT(!isbadpid(pid));
 
+    im = disable();
     ppcb = &proctab[pid];
     ppcb->state = PRREADY;
 
@@ -28,5 +30,6 @@ syscall ready(pid_typ pid, bool resch)
     {
         resched();
     }
+    restore(im);
     return OK;
 }
\ No newline at end of file
@@ -8,20 +8,24 @@
 
 #include <xinu.h>
 
-extern void ctxsw(void *, void *, ulong);
 int get_total_tickets(void);
 /**
  * Reschedule processor to next ready process.
  * Upon entry, currpid gives current process id.  Proctab[currpid].pstate 
  * gives correct NEXT state for current process if other than PRREADY.
+ * Interrupts are off while the queues and the FPU change hands; each
+ * process gets its own interrupt state back when it is resumed.
  * @return OK when the process is context switched back
  */
 syscall resched(void)
 {
     pcb *oldproc;               /* pointer to old process entry */
     pcb *newproc;               /* pointer to new process entry */
-    pcb *ppcb = &proctab[currpid];
+    int total_tickets, winner, ticket_counter;
+    int i;
+    irqmask im;
 
+    im = disable();
     oldproc = &proctab[currpid];
 
     /* place current process at end of ready queue */
@@ -31,37 +35,31 @@ syscall resched(void)
         enqueue(currpid, readylist);
     }
 
-    /**
-     * We recommend you use a helper function for the following:
-     * TODO: Get the total number of tickets from all processes that are in
-     * current and ready states.
-     * Use random() function to pick a random ticket. 
-     * Traverse through the process table to identify which proccess has the
-     * random ticket value.  Remove process from queue.
-     * Set currpid to the new process.
-     */
-
-
-
-    int total_tickets = get_total_tickets();
-    int random_ticket = random(total_tickets);    
-    int selected_pid;
-    int i = 0;
-    int ticket_counter;
-    pcb *checkedProc = &proctab[i];
-
-    for(i=0; i < NPROC; i++){
-        if (checkedProc->state == PRCURR || checkedProc->state == PRREADY){
-            ticket_counter += checkedProc->tickets;
-        }
-        if (random_ticket < ticket_counter)
+    /* Draw a ticket and find the ready process holding it */
+    total_tickets = get_total_tickets();
+    if (total_tickets > 0)
+    {
+        winner = random(total_tickets);
+        ticket_counter = 0;
+        for (i = 0; i < NPROC; i++)
         {
-            selected_pid = i;
-            break;
+            if (PRREADY == proctab[i].state)
+            {
+                ticket_counter += proctab[i].tickets;
+                if (winner < ticket_counter)
+                    break;
+            }
         }
-        checkedProc = &proctab[i];
+        remove(i);
+    }
+    else
+    {
+        // Nobody holds a ticket, so take the queue in order
+        i = dequeue(readylist);
     }
 
+    ktrace(KT_RESCHED, oldproc - proctab, i);
+    currpid = i;
     newproc = &proctab[currpid];
     newproc->state = PRCURR;    /* mark it currently running    */
 
@@ -69,24 +67,50 @@ syscall resched(void)
     preempt = QUANTUM;
 #endif
 
-    ctxsw(&oldproc->stkptr, &newproc->stkptr, (MAKE_SATP(currpid, newproc->pagetable)));
+    if (newproc == oldproc)
+    {
+        restore(im);
+        return OK;
+    }
+
+    // The next process turns the FPU back on when it first needs it
+    fpuswitch(oldproc);
+
+#if IRQTRACE
+    irqswitches++;
+#endif
+
+    // Only the callee-saved registers need to survive the call
+    ktrace(KT_CTXSW, oldproc - proctab, currpid);
+    ctxsw(&oldproc->stkptr, &newproc->stkptr);
 
     /* The OLD process returns here when resumed. */
+
+    // A process that killed itself is now off its kernel stack
+    if (deadkstack != NULL)
+    {
+        pgfree(deadkstack);
+        deadkstack = NULL;
+    }
+
+    restore(im);
     return OK;
 }
 
-int get_total_tickets(void){
-
+/**
+ * @return the number of tickets held by processes that are ready to run
+ */
+int get_total_tickets(void)
+{
     int total_tickets = 0;
-    int i = 0;
-    pcb *checkedProc = &proctab[i];
-
+    int i;
 
-    for (i=0; i < NPROC; i++){
-        if (checkedProc->state == PRCURR || checkedProc->state == PRREADY){
+    for (i = 0; i < NPROC; i++)
+    {
+        if (PRREADY == proctab[i].state)
+        {
             total_tickets += proctab[i].tickets;
         }
-        checkedProc = &proctab[i];
     }
     return total_tickets;
-}
\ No newline at end of file
+}
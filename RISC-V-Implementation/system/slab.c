@@ -0,0 +1,388 @@
+/**
+ * @file slab.c
+ * @provides kminit, kmcache_create, kmcache_alloc, kmcache_free, kmalloc, kfree, kmstat
+ *
+ * Object caches layered on the physical frame allocator.  Each cache
+ * hands out objects of one size carved from single-page slabs, so small
+ * kernel structures no longer cost a whole frame each.
+ */
+/* Embedded Xinu, Copyright (C) 2024.  All rights reserved. */
+
+#include <xinu.h>
+
+static struct kmslab *kmslabgrow(struct kmcache *cache);
+static void kmslablink(struct kmcache *cache, struct kmslab *slab);
+static void kmslabunlink(struct kmcache *cache, struct kmslab *slab);
+
+static uint nkmcache = 0;               /* caches in use in kmcachetab   */
+static struct kmcache *kmclass[8];      /* kmalloc size classes          */
+static const char *kmclassname[8] = {
+    "kmalloc-16", "kmalloc-32", "kmalloc-64", "kmalloc-128",
+    "kmalloc-256", "kmalloc-512", "kmalloc-1024", NULL
+};
+static ulong kmlarge = 0;               /* large kmalloc blocks in use   */
+
+/**
+ * Creates the kernel's standard caches.  Called once, after pgInit().
+ */
+void kminit(void)
+{
+    ulong size;
+    uint i;
+
+    nkmcache = 0;
+
+    swapcache = kmcache_create("swaparea", CONTEXT * sizeof(ulong), 64, 0);
+    pgtblcache = kmcache_create("pgtbl", PAGE_SIZE, PAGE_SIZE,
+                                KMC_PAGE | KMC_PGTBL);
+
+    for (i = 0, size = KM_MINCLASS; size <= KM_MAXCLASS; i++, size <<= 1)
+    {
+        kmclass[i] = kmcache_create(kmclassname[i], size, 16, 0);
+    }
+}
+
+/**
+ * Creates a cache of fixed-size objects.
+ * @param name  name shown by kmstat()
+ * @param size  size of each object in bytes
+ * @param align required alignment, a power of two no larger than
+ *              KMSLAB_HDR (or PAGE_SIZE for a KMC_PAGE cache)
+ * @param flags KMC_PAGE to back each object with a whole frame, plus
+ *              KMC_PGTBL if those frames hold page tables
+ * @return the new cache, or NULL if the table is full or the size is bad
+ */
+struct kmcache *kmcache_create(const char *name, ulong size, ulong align,
+                               uint flags)
+{
+    struct kmcache *cache;
+
+    if (nkmcache >= NKMCACHE || 0 == size || 0 == align
+        || (align & (align - 1)) != 0)
+    {
+        return NULL;
+    }
+
+    if (flags & KMC_PAGE)
+    {
+        if (size > PAGE_SIZE || align > PAGE_SIZE)
+            return NULL;
+        size = PAGE_SIZE;
+    }
+    else
+    {
+        if (align > KMSLAB_HDR)
+            return NULL;
+        if (align < sizeof(void *))
+            align = sizeof(void *);
+        size = (size + align - 1) & ~(align - 1);
+        if (size > PAGE_SIZE - KMSLAB_HDR)
+            return NULL;
+    }
+
+    cache = &kmcachetab[nkmcache++];
+    bzero(cache, sizeof(*cache));
+    strlcpy(cache->name, name, KMC_NAMELEN);
+    cache->objsize = size;
+    cache->flags = flags;
+    cache->perslab = (flags & KMC_PAGE) ? 1 : (PAGE_SIZE - KMSLAB_HDR) / size;
+
+    return cache;
+}
+
+/**
+ * Takes one object from a cache.  The object is cleared to zero.
+ * @param cache the cache to allocate from
+ * @return the object, or SYSERR if no memory is left
+ */
+void *kmcache_alloc(struct kmcache *cache)
+{
+    struct kmslab *slab;
+    void **obj;
+    irqmask im;
+
+    if (NULL == cache)
+    {
+        return (void *)SYSERR;
+    }
+
+    if (cache->flags & KMC_PAGE)
+    {
+        // pgalloc() already hands out cleared frames
+        obj = pgalloc();
+        im = disable();
+        if ((void *)SYSERR == obj)
+        {
+            cache->nfail++;
+            restore(im);
+            return (void *)SYSERR;
+        }
+        if (cache->flags & KMC_PGTBL)
+            PG_FRAME(obj)->flags = FR_PGTBL;
+    }
+    else
+    {
+        im = disable();
+        slab = cache->partial;
+        if (NULL == slab)
+        {
+            slab = kmslabgrow(cache);
+            if ((struct kmslab *)SYSERR == slab)
+            {
+                cache->nfail++;
+                restore(im);
+                return (void *)SYSERR;
+            }
+        }
+
+        if (0 == slab->inuse)
+            cache->nempty--;
+        obj = slab->freelist;
+        slab->freelist = *obj;
+        slab->inuse++;
+
+        // A full slab leaves the partial list until something is freed
+        if (NULL == slab->freelist)
+            kmslabunlink(cache, slab);
+    }
+
+    cache->nalloc++;
+    cache->inuse++;
+    if (cache->inuse > cache->peak)
+        cache->peak = cache->inuse;
+    restore(im);
+
+    if (!(cache->flags & KMC_PAGE))
+        memset(obj, 0, cache->objsize);
+
+    return (void *)obj;
+}
+
+/**
+ * Returns an object to its cache.  One empty slab is kept per cache so a
+ * single alloc/free pair does not bounce a page through the frame
+ * allocator; any further empty slabs are released.
+ * @param cache the cache the object came from
+ * @param obj   the object
+ * @return OK, or SYSERR if obj does not belong to cache
+ */
+syscall kmcache_free(struct kmcache *cache, void *obj)
+{
+    struct kmslab *slab;
+    ulong offset;
+    irqmask im;
+
+    if (NULL == cache || NULL == obj)
+    {
+        return SYSERR;
+    }
+
+    im = disable();
+    if (cache->flags & KMC_PAGE)
+    {
+        if (SYSERR == pgfree(obj))
+        {
+            restore(im);
+            return SYSERR;
+        }
+    }
+    else
+    {
+        slab = (struct kmslab *)truncpage(obj);
+        offset = (ulong)obj - (ulong)slab;
+        if (slab->cache != cache || offset < KMSLAB_HDR
+            || (offset - KMSLAB_HDR) % cache->objsize != 0
+            || 0 == slab->inuse)
+        {
+            restore(im);
+            return SYSERR;
+        }
+
+        if (NULL == slab->freelist)
+            kmslablink(cache, slab);
+        *(void **)obj = slab->freelist;
+        slab->freelist = obj;
+        slab->inuse--;
+
+        if (0 == slab->inuse)
+        {
+            if (cache->nempty > 0)
+            {
+                kmslabunlink(cache, slab);
+                slab->cache = NULL;
+                pgfree(slab);
+                cache->nslabs--;
+            }
+            else
+            {
+                cache->nempty++;
+            }
+        }
+    }
+
+    cache->nfree++;
+    cache->inuse--;
+    restore(im);
+
+    return OK;
+}
+
+/**
+ * Allocates kernel memory of any size.  Requests up to KM_MAXCLASS bytes
+ * come from the power-of-two size class caches; larger ones get a block
+ * of pages from pgalloc_order() with a slab header in front.
+ * @param size number of bytes needed
+ * @return zeroed memory, or SYSERR
+ */
+void *kmalloc(ulong size)
+{
+    struct kmslab *blk;
+    uint i, order;
+    irqmask im;
+
+    if (0 == size)
+    {
+        return (void *)SYSERR;
+    }
+
+    if (size <= KM_MAXCLASS)
+    {
+        for (i = 0; (KM_MINCLASS << i) < size; i++)
+            ;
+        return kmcache_alloc(kmclass[i]);
+    }
+
+    for (order = 0; PG_BLKSIZE(order) < size + KMSLAB_HDR; order++)
+    {
+        if (order == PG_MAXORDER)
+            return (void *)SYSERR;
+    }
+
+    blk = pgalloc_order(order);
+    if ((void *)SYSERR == blk)
+    {
+        return (void *)SYSERR;
+    }
+    blk->cache = NULL;
+    blk->inuse = order;
+    im = disable();
+    kmlarge++;
+    restore(im);
+
+    return (void *)((ulong)blk + KMSLAB_HDR);
+}
+
+/**
+ * Frees memory from kmalloc().
+ * @param ptr pointer returned by kmalloc()
+ * @return OK, or SYSERR if ptr did not come from kmalloc()
+ */
+syscall kfree(void *ptr)
+{
+    struct kmslab *slab;
+    irqmask im;
+
+    // kmalloc() never returns a page-aligned pointer
+    if (NULL == ptr || (void *)SYSERR == ptr || truncpage(ptr) == (ulong)ptr)
+    {
+        return SYSERR;
+    }
+
+    slab = (struct kmslab *)truncpage(ptr);
+    if (NULL == slab->cache)
+    {
+        if ((ulong)ptr != (ulong)slab + KMSLAB_HDR)
+            return SYSERR;
+        im = disable();
+        kmlarge--;
+        restore(im);
+        return pgfree_order(slab, slab->inuse);
+    }
+
+    return kmcache_free(slab->cache, ptr);
+}
+
+/**
+ * Prints per-cache statistics.
+ */
+void kmstat(void)
+{
+    struct kmcache *cache;
+    uint i;
+
+    kprintf("cache          size per slabs  inuse   peak    allocs     frees fail\r\n");
+    for (i = 0; i < nkmcache; i++)
+    {
+        cache = &kmcachetab[i];
+        kprintf("%-13s %5lu %3u %5u %6lu %6lu %9lu %9lu %4lu\r\n",
+                cache->name, cache->objsize, cache->perslab,
+                (cache->flags & KMC_PAGE) ? (uint)cache->inuse : cache->nslabs,
+                cache->inuse, cache->peak, cache->nalloc, cache->nfree,
+                cache->nfail);
+    }
+    kprintf("%lu large kmalloc blocks in use\r\n", kmlarge);
+}
+
+/**
+ * Adds a fresh slab page to a cache.
+ * @param cache the cache to grow
+ * @return the new slab, already on the partial list, or SYSERR
+ */
+static struct kmslab *kmslabgrow(struct kmcache *cache)
+{
+    struct kmslab *slab;
+    char *obj;
+    uint i;
+
+    slab = pgalloc_nozero();
+    if ((void *)SYSERR == slab)
+    {
+        return (struct kmslab *)SYSERR;
+    }
+
+    slab->cache = cache;
+    slab->inuse = 0;
+    PG_FRAME(slab)->flags = FR_SLAB;
+
+    // Chain the objects from the lowest address up
+    obj = (char *)slab + KMSLAB_HDR;
+    slab->freelist = obj;
+    for (i = 1; i < cache->perslab; i++, obj += cache->objsize)
+    {
+        *(void **)obj = obj + cache->objsize;
+    }
+    *(void **)obj = NULL;
+
+    kmslablink(cache, slab);
+    cache->nslabs++;
+    cache->nempty++;
+
+    return slab;
+}
+
+/**
+ * Puts a slab at the head of its cache's partial list.
+ */
+static void kmslablink(struct kmcache *cache, struct kmslab *slab)
+{
+    slab->prev = NULL;
+    slab->next = cache->partial;
+    if (cache->partial != NULL)
+        cache->partial->prev = slab;
+    cache->partial = slab;
+}
+
+/**
+ * Takes a slab off its cache's partial list.
+ */
+static void kmslabunlink(struct kmcache *cache, struct kmslab *slab)
+{
+    if (slab->prev != NULL)
+        slab->prev->next = slab->next;
+    else
+        cache->partial = slab->next;
+    if (slab->next != NULL)
+        slab->next->prev = slab->prev;
+    slab->next = NULL;
+    slab->prev = NULL;
+}
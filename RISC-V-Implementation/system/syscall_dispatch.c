@@ -24,6 +24,10 @@ syscall sc_yield(ulong *);
 syscall sc_getc(ulong *);
 syscall sc_putc(ulong *);
 syscall sc_kill(ulong *);
+syscall sc_idle(ulong *);
+syscall sc_fork(ulong *);
+syscall sc_brk(ulong *);
+syscall sc_sbrk(ulong *);
 
 /* table for determining how to call syscalls */
 const struct syscall_info syscall_table[] = {
@@ -44,6 +48,10 @@ const struct syscall_info syscall_table[] = {
     { 2, (void *)sc_none },     /* SYSCALL_JOIN      = 14 */
     { 1, (void *)sc_none },     /* SYSCALL_LOCK      = 15 */
     { 1, (void *)sc_none },   /* SYSCALL_UNLOCK    = 16 */
+    { 0, (void *)sc_idle },     /* SYSCALL_IDLE      = 17 */
+    { 0, (void *)sc_fork },     /* SYSCALL_FORK      = 18 */
+    { 1, (void *)sc_brk },      /* SYSCALL_BRK       = 19 */
+    { 1, (void *)sc_sbrk },     /* SYSCALL_SBRK      = 20 */
 };
 
 int nsyscall = sizeof(syscall_table) / sizeof(struct syscall_info);
@@ -57,9 +65,14 @@ int nsyscall = sizeof(syscall_table) / sizeof(struct syscall_info);
  */
 int syscall_dispatch(int code, ulong *args)
 {
+    int result;
+
     if (0 <= code && code < nsyscall)
     {
-        return (*syscall_table[code].handler) (args);
+        ktrace(KT_SYSCALL, code, currpid);
+        result = (*syscall_table[code].handler) (args);
+        ktrace(KT_SYSRET, code, result);
+        return result;
     }
     kprintf("ERROR: unknown syscall %d!\r\n", code);
     return SYSERR;
@@ -144,3 +157,83 @@ syscall user_kill(void)
 {
     SYSCALL(KILL);
 }
+
+/**
+ * syscall wrapper for idle-time housekeeping, called by the null process.
+ * @param args expands to: none
+ */
+syscall sc_idle(ulong *args)
+{
+    pgzeroidle(PG_ZEROBATCH);
+    return OK;
+}
+
+syscall user_idle(void)
+{
+    SYSCALL(IDLE);
+}
+
+/**
+ * syscall wrapper for fork().  The child is made ready straight away.
+ * @param args expands to: none
+ * @return the child's pid in the parent, 0 in the child, or SYSERR
+ */
+syscall sc_fork(ulong *args)
+{
+    pid_typ pid = forkproc(currpid);
+
+    if (SYSERR != pid)
+        ready(pid, RESCHED_NO);
+    return pid;
+}
+
+syscall user_fork(void)
+{
+    SYSCALL(FORK);
+}
+
+/**
+ * syscall wrapper for setting the program break.
+ * @param args expands to: void *addr
+ */
+syscall sc_brk(ulong *args)
+{
+    ulong addr = SCARG(ulong, args);
+
+    return vm_brk(currpid, addr);
+}
+
+syscall user_brk(void *addr)
+{
+    SYSCALL(BRK);
+}
+
+/**
+ * syscall wrapper for moving the program break.  System calls return an
+ * int, which cannot hold a heap address, so the old break comes back as
+ * an offset from USERHEAPADDR and user_sbrk() adds the base.
+ * @param args expands to: long incr
+ */
+syscall sc_sbrk(ulong *args)
+{
+    long incr = SCARG(long, args);
+    ulong old = proctab[currpid].vma[VMA_HEAP].end;
+
+    if (SYSERR == vm_brk(currpid, old + incr))
+        return SYSERR;
+    return old - USERHEAPADDR;
+}
+
+static syscall user_sbrkoffset(long incr)
+{
+    SYSCALL(SBRK);
+}
+
+void *user_sbrk(long incr)
+{
+    int offset = user_sbrkoffset(incr);
+
+    if (SYSERR == offset)
+        return (void *)SYSERR;
+    return (void *)(USERHEAPADDR + offset);
+}
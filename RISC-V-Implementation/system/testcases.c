@@ -87,6 +87,1366 @@ void printPageTable(pgtbl pagetable)
 
 }
 
+#define STRESS_SLOTS  512
+#define STRESS_ITERS  20000
+#define STRESS_REPORT 2000
+
+/**
+ * Fragmentation stress test for the buddy allocator.  Drains physical
+ * memory one page at a time, frees every other page, then the rest, and
+ * finally runs a random mix of block orders while reporting the largest
+ * free order over time.
+ */
+void pgstress(void)
+{
+	ulong *chain = NULL, *keep = NULL, *next;
+	ulong start, n = 0, i;
+	void *slot[STRESS_SLOTS];
+	uchar slotorder[STRESS_SLOTS];
+	void *blk;
+	int s, order;
+
+	start = pgfreepages();
+	kprintf("Start: %lu pages free, largest order %d\r\n",
+		start, pglargestorder());
+
+	/* Drain everything as single pages, chained through the pages */
+	while ((blk = pgalloc_nozero()) != (void *)SYSERR)
+	{
+		*(ulong **)blk = chain;
+		chain = blk;
+		n++;
+	}
+	kprintf("Drained %lu pages, largest order %d\r\n", n, pglargestorder());
+
+	/* Free every other page: half of memory free, none of it contiguous */
+	for (i = 0; chain != NULL; i++, chain = next)
+	{
+		next = (ulong *)*chain;
+		if (i & 1)
+		{
+			pgfree(chain);
+		}
+		else
+		{
+			*(ulong **)chain = keep;
+			keep = chain;
+		}
+	}
+	kprintf("Freed every other page: %lu free, largest order %d\r\n",
+		pgfreepages(), pglargestorder());
+
+	/* Free the rest, which must coalesce back into large blocks */
+	for (; keep != NULL; keep = next)
+	{
+		next = (ulong *)*keep;
+		pgfree(keep);
+	}
+	kprintf("Freed the rest: %lu free, largest order %d\r\n",
+		pgfreepages(), pglargestorder());
+
+	/* Random mix of orders, reporting the largest free order over time */
+	for (s = 0; s < STRESS_SLOTS; s++)
+		slot[s] = NULL;
+	for (i = 1; i <= STRESS_ITERS; i++)
+	{
+		s = random(STRESS_SLOTS);
+		if (slot[s] == NULL)
+		{
+			order = random(6);
+			blk = pgalloc_order(order);
+			if (blk != (void *)SYSERR)
+			{
+				slot[s] = blk;
+				slotorder[s] = order;
+			}
+		}
+		else
+		{
+			pgfree_order(slot[s], slotorder[s]);
+			slot[s] = NULL;
+		}
+
+		if (i % STRESS_REPORT == 0)
+		{
+			kprintf("iter %6lu: %lu pages free, largest order %d\r\n",
+				i, pgfreepages(), pglargestorder());
+		}
+	}
+	for (s = 0; s < STRESS_SLOTS; s++)
+	{
+		if (slot[s] != NULL)
+			pgfree_order(slot[s], slotorder[s]);
+	}
+
+	pgstat();
+	kprintf("Buddy stress %s\r\n",
+		(pgfreepages() == start) ? "PASSED" : "FAILED (pages leaked)");
+}
+
+#define CREATE_RUNS 8
+
+/**
+ * Times create() with the zeroed frame pool empty and then warm.
+ * @param warm TRUE to fill the zeroed pool before timing
+ * @return average cycles per create()
+ */
+ulong createlatency(bool warm)
+{
+	pid_typ pid[CREATE_RUNS];
+	ulong start, total = 0;
+	int i;
+
+	pgzerodrain();
+	if (warm)
+	{
+		while (pgzeroidle(PG_ZEROBATCH) > 0)
+			;
+	}
+
+	for (i = 0; i < CREATE_RUNS; i++)
+	{
+		start = clk_cycles();
+		pid[i] = create((void *)test_method, INITSTK, PRIORITY_LOW, "latency", 0);
+		total += clk_cycles() - start;
+	}
+	for (i = 0; i < CREATE_RUNS; i++)
+	{
+		if (pid[i] != SYSERR)
+			kill(pid[i]);
+	}
+
+	return total / CREATE_RUNS;
+}
+
+/**
+ * Shows how many frames each new process costs, prints the slab cache
+ * statistics, and checks that kill() gives the memory back.
+ */
+void slabtest(void)
+{
+	pid_typ pid[CREATE_RUNS];
+	ulong before, after;
+	int i;
+
+	before = pgfreepages();
+	for (i = 0; i < CREATE_RUNS; i++)
+		pid[i] = create((void *)test_method, INITSTK, PRIORITY_LOW, "slab", 0);
+	after = pgfreepages();
+
+	kprintf("%d processes took %lu frames\r\n", CREATE_RUNS, before - after);
+	kmstat();
+
+	for (i = 0; i < CREATE_RUNS; i++)
+	{
+		if (pid[i] != SYSERR)
+			kill(pid[i]);
+	}
+	kprintf("%lu frames still held after kill (cached empty slabs)\r\n",
+		before - pgfreepages());
+}
+
+#define MEMBENCH_REPS 32
+
+/* Byte loops matching the libxc routines that memcpy.S and memset.S replace */
+static void bytecopy(volatile uchar *dst, volatile uchar *src, ulong n)
+{
+	ulong i;
+
+	for (i = 0; i < n; i++)
+		dst[i] = src[i];
+}
+
+static void byteset(volatile uchar *dst, int c, ulong n)
+{
+	ulong i;
+
+	for (i = 0; i < n; i++)
+		dst[i] = c;
+}
+
+/**
+ * Prints the average cycles per call of the byte loops, memcpy()/memset(),
+ * and the whole-page routines for sizes from 8 bytes to a page.
+ */
+void membench(void)
+{
+	uchar *src = pgalloc();
+	uchar *dst = pgalloc();
+	ulong n, i, start;
+	ulong t[4];
+
+	if ((void *)SYSERR == src || (void *)SYSERR == dst)
+	{
+		kprintf("membench: out of memory\r\n");
+		return;
+	}
+
+	kprintf("  size  bytecopy    memcpy   byteset    memset\r\n");
+	for (n = 8; n <= PAGE_SIZE; n <<= 1)
+	{
+		start = clk_cycles();
+		for (i = 0; i < MEMBENCH_REPS; i++)
+			bytecopy(dst, src, n);
+		t[0] = clk_cycles() - start;
+
+		start = clk_cycles();
+		for (i = 0; i < MEMBENCH_REPS; i++)
+			memcpy(dst, src, n);
+		t[1] = clk_cycles() - start;
+
+		start = clk_cycles();
+		for (i = 0; i < MEMBENCH_REPS; i++)
+			byteset(dst, 0, n);
+		t[2] = clk_cycles() - start;
+
+		start = clk_cycles();
+		for (i = 0; i < MEMBENCH_REPS; i++)
+			memset(dst, 0, n);
+		t[3] = clk_cycles() - start;
+
+		kprintf("%6lu %9lu %9lu %9lu %9lu\r\n", n,
+			t[0] / MEMBENCH_REPS, t[1] / MEMBENCH_REPS,
+			t[2] / MEMBENCH_REPS, t[3] / MEMBENCH_REPS);
+	}
+
+	start = clk_cycles();
+	for (i = 0; i < MEMBENCH_REPS; i++)
+		pgclear(dst);
+	t[0] = clk_cycles() - start;
+
+	start = clk_cycles();
+	for (i = 0; i < MEMBENCH_REPS; i++)
+		pgcopy(dst, src);
+	t[1] = clk_cycles() - start;
+
+	kprintf("pgclear %lu, pgcopy %lu cycles per page\r\n",
+		t[0] / MEMBENCH_REPS, t[1] / MEMBENCH_REPS);
+
+	pgfree(src);
+	pgfree(dst);
+}
+
+#define FORKBENCH_ADDR 0x2000000000UL	/* private range for the extra pages */
+#define FORKBENCH_MAX  1024
+
+/**
+ * Times forkproc() on a process with more and more pages mapped, next to
+ * what copying those pages up front would cost, then checks that store
+ * faults copy a shared page once and only once.
+ */
+void forkbench(void)
+{
+	pid_typ parent, child;
+	pgtbl pt;
+	ulong *pg, *first = NULL, *scratch, *pte;
+	ulong before, mapped, n, i, start, t, free;
+
+	before = pgfreepages();
+	parent = create((void *)test_method, INITSTK, PRIORITY_LOW, "forkbench", 0);
+	scratch = pgalloc();
+	if (SYSERR == parent || (void *)SYSERR == scratch)
+	{
+		kprintf("forkbench: out of memory\r\n");
+		return;
+	}
+	pt = proctab[parent].pagetable;
+
+	kprintf(" pages  fork cycles  copying them\r\n");
+	for (mapped = 0, n = 0; n <= FORKBENCH_MAX; n = n ? n << 2 : 16)
+	{
+		// Grow the parent; the mapping holds its own reference
+		for (; mapped < n; mapped++)
+		{
+			pg = pgalloc();
+			if ((void *)SYSERR == pg)
+				break;
+			mapPage(pt, pg, FORKBENCH_ADDR + mapped * PAGE_SIZE,
+				PTE_R | PTE_W | PTE_U | PTE_A | PTE_D, (ulong)pg);
+			pgfree(pg);
+			if (NULL == first)
+				first = pg;
+		}
+		if (mapped < n)
+			break;
+
+		start = clk_cycles();
+		child = forkproc(parent);
+		t = clk_cycles() - start;
+		if (SYSERR == child)
+			break;
+		kill(child);
+
+		start = clk_cycles();
+		for (i = 0; i < n; i++)
+			pgcopy(scratch, first);
+		kprintf("%6lu %12lu %13lu\r\n", n, t, clk_cycles() - start);
+	}
+
+	// The first store copies the page, the second sharer just gets it back
+	child = forkproc(parent);
+	if (first != NULL && child != SYSERR)
+	{
+		free = pgfreepages();
+		vm_cowfault(proctab[child].pagetable, FORKBENCH_ADDR);
+		t = free - pgfreepages();
+		vm_cowfault(pt, FORKBENCH_ADDR);
+		kprintf("Copy-on-write %s (%lu page copied, parent refcount %u)\r\n",
+			(1 == t && free - pgfreepages() == 1
+			 && 1 == PG_FRAME(first)->refcount) ? "PASSED" : "FAILED",
+			t, PG_FRAME(first)->refcount);
+		kill(child);
+	}
+
+	// The stack page from create() also holds the reference in stkbase.
+	// The child's store copies it; the parent's then has the only
+	// mapping and must keep the frame
+	child = forkproc(parent);
+	if (child != SYSERR)
+	{
+		pg = proctab[parent].stkbase;
+		free = pgfreepages();
+		vm_cowfault(proctab[child].pagetable, PROCSTACKADDR);
+		vm_cowfault(pt, PROCSTACKADDR);
+		t = free - pgfreepages();
+		pte = pgLookup(pt, PROCSTACKADDR);
+		kprintf("Copy-on-write stack %s (%lu page copied, parent %s)\r\n",
+			(1 == t && pte != NULL && PTE2PA(*pte) == (ulong)pg
+			 && (*pte & PTE_W)) ? "PASSED" : "FAILED", t,
+			(pte != NULL && PTE2PA(*pte) == (ulong)pg)
+			? "kept its frame" : "copied");
+		kill(child);
+	}
+
+	kill(parent);
+	pgfree(scratch);
+	kprintf("%lu frames still held (cached empty slabs)\r\n",
+		before - pgfreepages());
+}
+
+#define HEAP_RESERVE (4 * 1024 * 1024)
+#define HEAP_STRIDE  8
+
+/**
+ * User process that grows its heap through umalloc().
+ */
+void heapuser(void)
+{
+	ulong *blk[8];
+	int i;
+
+	for (i = 0; i < 8; i++)
+	{
+		blk[i] = umalloc(1000 * (i + 1));
+		blk[i][0] = i;
+	}
+	for (i = 0; i < 8; i += 2)
+		ufree(blk[i]);
+	kprintf("umalloc: break at 0x%lX\r\n", (ulong)user_sbrk(0));
+}
+
+/**
+ * Reserves a large heap for a process, touches a fraction of it the way
+ * the page fault path would, and compares resident with reserved memory.
+ */
+void heaptest(void)
+{
+	pid_typ pid;
+	ulong before, va;
+
+	before = pgfreepages();
+	pid = create((void *)heapuser, INITSTK, PRIORITY_LOW, "heap", 0);
+	if (SYSERR == pid)
+	{
+		kprintf("heaptest: out of memory\r\n");
+		return;
+	}
+
+	vm_brk(pid, USERHEAPADDR + HEAP_RESERVE);
+	kprintf("Reserved %lu KiB: %lu KiB resident, %lu frames used\r\n",
+		(ulong)HEAP_RESERVE >> 10, vm_heaprss(pid) * PAGE_SIZE >> 10,
+		before - pgfreepages());
+
+	for (va = USERHEAPADDR; va < USERHEAPADDR + HEAP_RESERVE;
+	     va += HEAP_STRIDE * PAGE_SIZE)
+		vm_pagefault(pid, E_STORE_AMO_PAGEFAULT, va);
+	kprintf("Touched every %dth page: %lu KiB resident\r\n",
+		HEAP_STRIDE, vm_heaprss(pid) * PAGE_SIZE >> 10);
+
+	vm_brk(pid, USERHEAPADDR + HEAP_RESERVE / 4);
+	kprintf("Shrunk to %lu KiB: %lu KiB resident\r\n",
+		(ulong)HEAP_RESERVE >> 12, vm_heaprss(pid) * PAGE_SIZE >> 10);
+
+	kprintf("Fault above the break %s\r\n",
+		(SYSERR == vm_pagefault(pid, E_LOAD_PAGEFAULT,
+					USERHEAPADDR + HEAP_RESERVE / 2))
+		? "refused" : "MAPPED (wrong)");
+
+	kill(pid);
+	kprintf("%lu frames still held after kill\r\n", before - pgfreepages());
+
+	pid = create((void *)heapuser, INITSTK, PRIORITY_LOW, "heapuser", 0);
+	if (pid != SYSERR)
+		ready(pid, RESCHED_YES);
+}
+
+/**
+ * Prints whether a simulated fault had the expected outcome.
+ */
+static void faultcheck(const char *what, int result, int expect)
+{
+	kprintf("%-36s %s\r\n", what, (result == expect) ? "ok" : "WRONG");
+}
+
+/**
+ * Feeds the page fault path the faults a user process would take and
+ * checks how each is classified, then prints the fault counters.
+ */
+void faulttest(void)
+{
+	pid_typ pid, child;
+	pcb *ppcb;
+
+	pid = create((void *)test_method, INITSTK, PRIORITY_LOW, "faults", 0);
+	if (SYSERR == pid)
+	{
+		kprintf("faulttest: out of memory\r\n");
+		return;
+	}
+	ppcb = &proctab[pid];
+	vm_brk(pid, USERHEAPADDR + 4 * PAGE_SIZE);
+
+	pgzerodrain();
+	faultcheck("heap load, zero pool empty",
+		vm_pagefault(pid, E_LOAD_PAGEFAULT, USERHEAPADDR), OK);
+	while (pgzeroidle(PG_ZEROBATCH) > 0)
+		;
+	faultcheck("heap store, zero pool warm",
+		vm_pagefault(pid, E_STORE_AMO_PAGEFAULT, USERHEAPADDR + PAGE_SIZE), OK);
+	faultcheck("heap store to a mapped page",
+		vm_pagefault(pid, E_STORE_AMO_PAGEFAULT, USERHEAPADDR), SYSERR);
+	faultcheck("execute from the heap",
+		vm_pagefault(pid, E_INSTRUCTION_PAGEFAULT, USERHEAPADDR + 2 * PAGE_SIZE), SYSERR);
+	faultcheck("store above the break",
+		vm_pagefault(pid, E_STORE_AMO_PAGEFAULT, USERHEAPADDR + 8 * PAGE_SIZE), SYSERR);
+	faultcheck("stack growth by three pages",
+		vm_pagefault(pid, E_STORE_AMO_PAGEFAULT, PROCSTACKADDR - 3 * PAGE_SIZE), OK);
+	faultcheck("store past the stack limit",
+		vm_pagefault(pid, E_STORE_AMO_PAGEFAULT,
+			PROCSTACKADDR + PAGE_SIZE - roundpage(ppcb->stklen) - PAGE_SIZE), SYSERR);
+	faultcheck("store to kernel text",
+		vm_pagefault(pid, E_STORE_AMO_PAGEFAULT, (ulong)&_start), SYSERR);
+
+	child = forkproc(pid);
+	if (child != SYSERR)
+	{
+		faultcheck("copy-on-write store in the child",
+			vm_pagefault(child, E_STORE_AMO_PAGEFAULT, USERHEAPADDR), OK);
+		faultcheck("copy-on-write store in the parent",
+			vm_pagefault(pid, E_STORE_AMO_PAGEFAULT, USERHEAPADDR), OK);
+		kprintf("child:  %lu minor, %lu major faults\r\n",
+			proctab[child].minflt, proctab[child].majflt);
+		kill(child);
+	}
+	kprintf("parent: %lu minor, %lu major faults, stack from 0x%lX\r\n",
+		ppcb->minflt, ppcb->majflt, ppcb->vma[VMA_STACK].start);
+
+	kill(pid);
+}
+
+#define UNMAP_ADDR  0x2000000000UL
+#define UNMAP_PAGES 512
+
+/**
+ * Maps a run of fresh frames into a pagetable for unmaptest().
+ * @return the number of pages mapped
+ */
+static ulong unmapfill(pgtbl pt)
+{
+	ulong i;
+	void *pg;
+
+	for (i = 0; i < UNMAP_PAGES; i++)
+	{
+		pg = pgalloc();
+		if ((void *)SYSERR == pg)
+			break;
+		mapPage(pt, pg, UNMAP_ADDR + i * PAGE_SIZE,
+			PTE_R | PTE_W | PTE_U | PTE_A | PTE_D, (ulong)pg);
+		pgfree(pg);
+	}
+	return i;
+}
+
+/**
+ * Checks protectAddress() and unmapAddress(), and times unmapping a range
+ * in one call against one call per page.
+ */
+void unmaptest(void)
+{
+	pid_typ pid;
+	pgtbl pt;
+	ulong before, mapped, i, start, t;
+
+	pid = create((void *)test_method, INITSTK, PRIORITY_LOW, "unmap", 0);
+	if (SYSERR == pid)
+	{
+		kprintf("unmaptest: out of memory\r\n");
+		return;
+	}
+	pt = proctab[pid].pagetable;
+	before = pgfreepages();
+
+	mapped = unmapfill(pt);
+	protectAddress(pt, UNMAP_ADDR, 4 * PAGE_SIZE, PTE_R);
+	kprintf("protect to read-only %s\r\n",
+		(PTE_R == (*pgLookup(pt, UNMAP_ADDR + 3 * PAGE_SIZE) & PTE_LEAF)
+		 && (*pgLookup(pt, UNMAP_ADDR + 4 * PAGE_SIZE) & PTE_W))
+		? "PASSED" : "FAILED");
+	kprintf("protect write-only refused: %s\r\n",
+		(SYSERR == protectAddress(pt, UNMAP_ADDR, PAGE_SIZE, PTE_W))
+		? "PASSED" : "FAILED");
+	kprintf("unmap of the shared kernel half refused: %s\r\n",
+		(SYSERR == unmapAddress(pt, (ulong)&_start, PAGE_SIZE))
+		? "PASSED" : "FAILED");
+
+	start = clk_cycles();
+	unmapAddress(pt, UNMAP_ADDR, mapped * PAGE_SIZE);
+	t = clk_cycles() - start;
+	kprintf("unmap %lu pages in one call: %lu cycles, %lu frames still held\r\n",
+		mapped, t, before - pgfreepages());
+
+	mapped = unmapfill(pt);
+	start = clk_cycles();
+	for (i = 0; i < mapped; i++)
+		unmapAddress(pt, UNMAP_ADDR + i * PAGE_SIZE, PAGE_SIZE);
+	t = clk_cycles() - start;
+	kprintf("unmap %lu pages one at a time: %lu cycles, %lu frames still held\r\n",
+		mapped, t, before - pgfreepages());
+
+	kill(pid);
+}
+
+#define MAPTEST_ADDR 0x3000000000UL
+
+/**
+ * Times building the kernel's RAM mapping in a scratch pagetable one page
+ * at a time and in one mapAddress() call, then checks that a mapping which
+ * runs out of table frames part way is rolled back.
+ */
+void maptest(void)
+{
+	pgtbl pt;
+	ulong base, len, addr, start, t, before;
+	void **chain = NULL, **pg;
+	int result, i;
+
+	pt = kmcache_alloc(pgtblcache);
+	if ((pgtbl)SYSERR == pt)
+	{
+		kprintf("maptest: out of memory\r\n");
+		return;
+	}
+	base = (ulong)memheap;
+	len = truncpage((ulong)platform.maxaddr - base);
+
+	start = clk_cycles();
+	for (addr = base; addr < base + len; addr += PAGE_SIZE)
+		mapPage(pt, NULL, addr, PTE_R | PTE_W | PTE_A | PTE_D, addr);
+	t = clk_cycles() - start;
+	kprintf("map %lu pages one at a time: %lu cycles\r\n", len / PAGE_SIZE, t);
+	unmapAddress(pt, base, len);
+
+	start = clk_cycles();
+	mapAddress(pt, base, base, len, PTE_R | PTE_W | PTE_A | PTE_D);
+	t = clk_cycles() - start;
+	kprintf("map %lu pages in one call:  %lu cycles\r\n", len / PAGE_SIZE, t);
+	unmapAddress(pt, base, len);
+
+	// Leave three frames: a level 1 table and two of the four level 0s
+	while ((pg = pgalloc_nozero()) != (void **)SYSERR)
+	{
+		*pg = chain;
+		chain = pg;
+	}
+	for (i = 0; i < 3 && chain != NULL; i++)
+	{
+		pg = chain;
+		chain = *pg;
+		pgfree(pg);
+	}
+	before = pgfreepages();
+	result = mapAddress(pt, MAPTEST_ADDR, base, 4 * 512 * PAGE_SIZE,
+			    PTE_R | PTE_W | PTE_A | PTE_D);
+	kprintf("map without table frames rolled back: %s\r\n",
+		(SYSERR == result && NULL == pgLookup(pt, MAPTEST_ADDR)
+		 && pgfreepages() == before) ? "PASSED" : "FAILED");
+	while (chain != NULL)
+	{
+		pg = chain;
+		chain = *pg;
+		pgfree(pg);
+	}
+	kmcache_free(pgtblcache, pt);
+
+	kprintf("create() with cold zero pool: %lu cycles\r\n",
+		createlatency(FALSE));
+}
+
+#define FPTEST_WORKERS 4
+#define FPTEST_ROUNDS  64
+#define FPTEST_STEPS   2000
+
+/**
+ * Runs a floating-point recurrence that keeps eight values live in FP
+ * registers, yielding between rounds so other FP processes run in between.
+ * @param seed  added on every step
+ * @return the bits of the final sum
+ */
+static ulong fprun(double seed)
+{
+	double a = 1, b = 2, c = 3, d = 4, e = 5, f = 6, g = 7, h = 8;
+	ulong bits;
+	int r, i;
+
+	for (r = 0; r < FPTEST_ROUNDS; r++)
+	{
+		for (i = 0; i < FPTEST_STEPS; i++)
+		{
+			a = a * 0.999999 + seed;
+			b = b * 0.999998 + a;
+			c = c * 0.999997 - b * 1e-6;
+			d = d * 0.999996 + c;
+			e = e * 0.999995 - d * 1e-6;
+			f = f * 0.999994 + e;
+			g = g * 0.999993 - f * 1e-6;
+			h = h * 0.999992 + g;
+		}
+		user_yield();
+	}
+	h += a + b + c + d + e + f + g;
+	memcpy(&bits, &h, sizeof(bits));
+	return bits;
+}
+
+/**
+ * User process for fptest().  Odd and even pids use different seeds and
+ * rounding modes, and each runs the recurrence twice while the others
+ * run theirs; both passes must agree bit for bit and the rounding mode
+ * must still be the one it set.
+ */
+void fpworker(void)
+{
+	ulong mode = (currpid & 1) ? 1 : 0;	/* round toward zero, or nearest */
+	double seed = (currpid & 1) ? 0.003 : 0.005;
+	ulong first, second, frm;
+
+	asm volatile ("fsrm %0"::"r" (mode));
+	first = fprun(seed);
+	second = fprun(seed);
+	asm volatile ("frrm %0":"=r" (frm));
+
+	kprintf("fpworker %d: result 0x%016lX, %s, %lu FPU traps\r\n",
+		currpid, first,
+		(first == second && frm == mode) ? "PASSED" : "FAILED",
+		proctab[currpid].fptraps);
+}
+
+/**
+ * User process for fptest() that never touches the FPU.
+ */
+void fpintworker(void)
+{
+	volatile ulong sum = 0;
+	int r, i;
+
+	for (r = 0; r < FPTEST_ROUNDS; r++)
+	{
+		for (i = 0; i < FPTEST_STEPS; i++)
+			sum += i;
+		user_yield();
+	}
+	kprintf("integer worker %d: %lu FPU traps (%s)\r\n", currpid,
+		proctab[currpid].fptraps,
+		(0 == proctab[currpid].fptraps) ? "PASSED" : "FAILED");
+}
+
+/**
+ * Runs several floating-point processes against each other with lazy FPU
+ * switching, plus one that only uses integers.  Workers of the same pid
+ * parity print the same result.
+ */
+void fptest(void)
+{
+	pid_typ pid;
+	int i;
+
+	for (i = 0; i < FPTEST_WORKERS; i++)
+	{
+		pid = create((void *)fpworker, INITSTK, PRIORITY_LOW, "fpworker", 0);
+		if (pid != SYSERR)
+			ready(pid, RESCHED_NO);
+	}
+	pid = create((void *)fpintworker, INITSTK, PRIORITY_LOW, "fpint", 0);
+	if (pid != SYSERR)
+		ready(pid, RESCHED_YES);
+}
+
+#define PINGPONG_ROUNDS 10000
+
+static void *pingctx, *pongctx;
+
+/**
+ * Other half of pingpong(): hands the processor straight back, forever.
+ */
+static void pong(void)
+{
+	while (1)
+		ctxsw(&pongctx, &pingctx);
+}
+
+/**
+ * Times ctxsw() alone by bouncing between main and a bare kernel context
+ * on a page of its own, with no scheduler in between.
+ */
+void pingpong(void)
+{
+	ulong *stack, *frame;
+	ulong start, cycles;
+	irqmask im;
+	int i;
+
+	stack = pgalloc();
+	if ((void *)SYSERR == stack)
+	{
+		kprintf("pingpong: no memory\r\n");
+		return;
+	}
+
+	// A frame ctxsw() can pop that "returns" into pong()
+	frame = stack + PAGE_SIZE / sizeof(ulong) - CTXSW_FRAME;
+	frame[CTXSW_RA] = (ulong)pong;
+	pongctx = frame;
+
+	im = disable();
+	start = clk_cycles();
+	for (i = 0; i < PINGPONG_ROUNDS; i++)
+		ctxsw(&pingctx, &pongctx);
+	cycles = clk_cycles() - start;
+	restore(im);
+
+	kprintf("ctxsw: %lu cycles per switch (%d round trips)\r\n",
+		cycles / (2 * PINGPONG_ROUNDS), PINGPONG_ROUNDS);
+	pgfree(stack);
+}
+
+#define LATENCY_PASSES 20
+
+/**
+ * Maps and unmaps all of kernel RAM in a scratch pagetable over and over,
+ * a long kernel operation, and reports the worst timer latency seen.
+ * @param masked TRUE to keep interrupts off for each pass, as the kernel
+ *               did before it could take them itself
+ * @return the worst latency in microseconds
+ */
+static ulong latencyrun(pgtbl pt, ulong base, ulong len, bool masked)
+{
+	irqmask im = 0;
+	int i;
+
+	clkmaxlat = 0;
+	for (i = 0; i < LATENCY_PASSES; i++)
+	{
+		if (masked)
+			im = disable();
+		mapAddress(pt, base, base, len, PTE_R | PTE_W | PTE_A | PTE_D);
+		unmapAddress(pt, base, len);
+		if (masked)
+			restore(im);
+	}
+	return clk_tons(clkmaxlat) / 1000;
+}
+
+/**
+ * Timer interrupt latency with the kernel idle, then under load from long
+ * mapAddress() calls with interrupts masked and with them on.
+ */
+void latencytest(void)
+{
+	pgtbl pt;
+	ulong base, len, start;
+
+	pt = kmcache_alloc(pgtblcache);
+	if ((pgtbl)SYSERR == pt)
+	{
+		kprintf("latencytest: out of memory\r\n");
+		return;
+	}
+	base = (ulong)memheap;
+	len = truncpage((ulong)platform.maxaddr - base);
+
+	clkmaxlat = 0;
+	start = clk_ns();
+	while (clk_ns() - start < 2000000000UL)
+		;
+	kprintf("timer latency, kernel idle:              %5lu us\r\n",
+		clk_tons(clkmaxlat) / 1000);
+	kprintf("timer latency, mapAddress() masked:      %5lu us\r\n",
+		latencyrun(pt, base, len, TRUE));
+	kprintf("timer latency, mapAddress() preemptible: %5lu us\r\n",
+		latencyrun(pt, base, len, FALSE));
+
+	kmcache_free(pgtblcache, pt);
+}
+
+#define VECTOR_ROUNDS 1000
+
+static volatile ulong softstamp;
+
+/**
+ * Software interrupt handler for vectortest(): notes when it ran.
+ */
+static interrupt softstampintr(void)
+{
+	softstamp = clk_cycles();
+}
+
+/**
+ * Raises a software interrupt in the kernel over and over and reports the
+ * cycles from raising it to the handler running.
+ * @param mode STVEC_MODE_VECTORED or STVEC_MODE_DIRECT
+ */
+static void vectorrun(ulong mode)
+{
+	ulong start, cycles, total, min;
+	int i;
+
+	set_stvec((ulong)trapvec | mode);
+	total = 0;
+	min = (ulong)-1;
+	for (i = 0; i < VECTOR_ROUNDS; i++)
+	{
+		softstamp = 0;
+		start = clk_cycles();
+		sip_set(RISCV_SIP_SSIP);
+		while (0 == softstamp)
+			;
+		cycles = softstamp - start;
+		total += cycles;
+		if (cycles < min)
+			min = cycles;
+	}
+	kprintf("%s: entry to handler min %lu, avg %lu cycles\r\n",
+		(STVEC_MODE_VECTORED == mode) ? "vectored" : "direct  ",
+		min, total / VECTOR_ROUNDS);
+}
+
+/**
+ * Interrupt entry latency through the vectored stubs against the direct
+ * path through interrupt() and dispatch().
+ */
+void vectortest(void)
+{
+	ulong stvec = get_stvec();
+
+	softhandler = softstampintr;
+	vectorrun(STVEC_MODE_VECTORED);
+	vectorrun(STVEC_MODE_DIRECT);
+	softhandler = NULL;
+	set_stvec(stvec);
+}
+
+/**
+ * Software interrupt handler for irqtracetest(): does nothing, so only
+ * the entry and exit paths are timed.
+ */
+static interrupt softnop(void)
+{
+}
+
+/**
+ * Gathers interrupt statistics for a second of clock ticks, a hundred
+ * software interrupts and one deliberate 100000 cycle interrupts-off
+ * window, then prints them.
+ */
+void irqtracetest(void)
+{
+	ulong start;
+	irqmask im;
+	int i;
+
+	irqtrace_reset();
+
+	start = clk_ns();
+	while (clk_ns() - start < 1000000000UL)
+		;
+
+	softhandler = softnop;
+	for (i = 0; i < 100; i++)
+		sip_set(RISCV_SIP_SSIP);
+	softhandler = NULL;
+
+	im = disable();
+	start = clk_cycles();
+	while (clk_cycles() - start < 100000)
+		;
+	restore(im);
+
+	irqstat();
+}
+
+#define KTIMER_COUNT 2000
+#define KTIMER_SPAN  50000      /* microseconds */
+
+static ulong ktfired, ktbad, ktlatemax, ktlatetotal, ktbeats;
+
+/**
+ * Timer function for ktimertest(): notes how late it ran.  Timers with an
+ * odd argument were cancelled and must not run.
+ */
+static void ktimerlate(struct ktimer *t, void *arg)
+{
+	ulong late = rdtime() - t->when;
+
+	if ((ulong)arg & 1)
+		ktbad++;
+	ktfired++;
+	ktlatetotal += late;
+	if (late > ktlatemax)
+		ktlatemax = late;
+}
+
+/**
+ * Periodic timer function for ktimertest().
+ */
+static void ktimerbeat(struct ktimer *t, void *arg)
+{
+	ktbeats++;
+}
+
+/**
+ * Arms a few thousand one-shot timers across 50 ms, cancels every other
+ * one, and runs a 250 us periodic timer alongside for a second.  Reports
+ * how late the timers fired and how many ran that should not have.
+ */
+void ktimertest(void)
+{
+	struct ktimer *timers, beat;
+	ulong start;
+	int i;
+
+	timers = kmalloc(KTIMER_COUNT * sizeof(struct ktimer));
+	if ((void *)SYSERR == timers)
+	{
+		kprintf("ktimertest: out of memory\r\n");
+		return;
+	}
+
+	ktfired = ktbad = ktlatemax = ktlatetotal = ktbeats = 0;
+	ktimer_init(&beat, ktimerbeat, NULL);
+	ktimer_arm(&beat, 250, 250);
+	for (i = 0; i < KTIMER_COUNT; i++)
+	{
+		ktimer_init(&timers[i], ktimerlate, (void *)(ulong)i);
+		ktimer_arm(&timers[i], 1000 + random(KTIMER_SPAN), 0);
+	}
+	for (i = 1; i < KTIMER_COUNT; i += 2)
+		ktimer_cancel(&timers[i]);
+	ktimerstat();
+
+	start = clk_ns();
+	while (clk_ns() - start < 1000000000UL)
+		;
+	ktimer_cancel(&beat);
+
+	kprintf("%lu of %d timers fired, %lu cancelled ones ran\r\n",
+		ktfired, KTIMER_COUNT / 2, ktbad);
+	kprintf("late by avg %lu, max %lu ns\r\n",
+		ktfired ? clk_tons(ktlatetotal / ktfired) : 0,
+		clk_tons(ktlatemax));
+	kprintf("250 us periodic timer: %lu beats in 1 s\r\n", ktbeats);
+	ktimerstat();
+	kfree(timers);
+}
+
+#define CLKARM_ROUNDS 1000
+
+/**
+ * Cycles to arm the clock, against the old sequence that waited for the
+ * reload bit to clear, then statistics for a second of clock interrupts:
+ * the top half under the clock's source, the bottom half under ssoft.
+ */
+void clocktest(void)
+{
+#ifndef _XINU_PLATFORM_RISCV_QEMU_
+	volatile struct timer *t = (volatile struct timer *)TIMER_BASE;
+#endif
+	ulong start, deadline, total;
+	irqmask im;
+	int i;
+
+	im = disable();
+	deadline = clkdeadline;
+	total = 0;
+	for (i = 0; i < CLKARM_ROUNDS; i++)
+	{
+		start = clk_cycles();
+		clkarm(rdtime() + platform.clkfreq);
+		total += clk_cycles() - start;
+	}
+	kprintf("clkarm(): avg %lu cycles\r\n", total / CLKARM_ROUNDS);
+
+#ifndef _XINU_PLATFORM_RISCV_QEMU_
+	total = 0;
+	for (i = 0; i < CLKARM_ROUNDS; i++)
+	{
+		start = clk_cycles();
+		t->t0_ctrl &= ~TMR0_EN;
+		t->t0_intv = platform.clkfreq;
+		t->t0_ctrl |= TMR0_RELOAD;
+		while (t->t0_ctrl & TMR0_RELOAD)
+			;
+		t->t0_ctrl |= TMR0_EN;
+		total += clk_cycles() - start;
+	}
+	kprintf("reload and wait: avg %lu cycles\r\n", total / CLKARM_ROUNDS);
+#endif
+	clkarm(deadline);
+	restore(im);
+
+	irqtrace_reset();
+	start = clk_ns();
+	while (clk_ns() - start < 1000000000UL)
+		;
+	irqstat();
+}
+
+#define CLKNS_ROUNDS 10000
+
+static volatile ulong clknssink;
+
+/**
+ * User process for clknstest(): reads the clock through the clock page.
+ */
+void clknsuser(void)
+{
+	ulong first, second;
+
+	first = clk_ns();
+	second = clk_ns();
+	kprintf("user: clk_ns() %lu ns, next read %lu ns later\r\n",
+		first, second - first);
+}
+
+/**
+ * Cycles per clk_ns() against dividing by platform.clkfreq, a check that
+ * the clock never goes backwards, then clk_ns() from a user process.
+ */
+void clknstest(void)
+{
+	ulong start, prev, now, counts, back;
+	pid_typ pid;
+	int i;
+
+	kprintf("clock page: %lu counts/s, ns = counts * %lu >> %d\r\n",
+		CLKPAGE->freq, CLKPAGE->nsmult, CLK_NSSHIFT);
+
+	start = clk_cycles();
+	for (i = 0; i < CLKNS_ROUNDS; i++)
+		clknssink = clk_ns();
+	kprintf("clk_ns():  avg %lu cycles\r\n",
+		(clk_cycles() - start) / CLKNS_ROUNDS);
+
+	start = clk_cycles();
+	for (i = 0; i < CLKNS_ROUNDS; i++)
+	{
+		counts = rdtime() - CLKPAGE->boot;
+		clknssink = counts / platform.clkfreq * 1000000000UL
+			+ counts % platform.clkfreq * 1000000000UL / platform.clkfreq;
+	}
+	kprintf("division:  avg %lu cycles\r\n",
+		(clk_cycles() - start) / CLKNS_ROUNDS);
+
+	back = 0;
+	prev = clk_ns();
+	for (i = 0; i < CLKNS_ROUNDS * 10; i++)
+	{
+		now = clk_ns();
+		if (now < prev)
+			back++;
+		prev = now;
+	}
+	kprintf("%lu of %d reads went backwards; %lu s since boot\r\n",
+		back, CLKNS_ROUNDS * 10, prev / 1000000000UL);
+
+	pid = create((void *)clknsuser, INITSTK, PRIORITY_LOW, "clkns", 0);
+	if (pid != SYSERR)
+		ready(pid, RESCHED_YES);
+}
+
+#define CONSOLE_LINES 60
+
+/**
+ * Writes the same burst of console lines polled and then through the
+ * interrupt-driven rings, and reports the cycles the writer spent on each.
+ */
+void consoletest(void)
+{
+	ulong start, polled, queued;
+	int i;
+
+	uartpoll(TRUE);
+	start = clk_cycles();
+	for (i = 0; i < CONSOLE_LINES; i++)
+		kprintf("console %2d: the quick brown fox jumps over the lazy dog\r\n", i);
+	polled = clk_cycles() - start;
+	uartpoll(FALSE);
+
+	irqtrace_reset();
+	start = clk_cycles();
+	for (i = 0; i < CONSOLE_LINES; i++)
+		kprintf("console %2d: the quick brown fox jumps over the lazy dog\r\n", i);
+	queued = clk_cycles() - start;
+
+	// Let the interrupt finish sending before the report
+	start = clk_ns();
+	while (clk_ns() - start < 1000000000UL)
+		;
+	kprintf("%d lines: writer spent %lu cycles polled, %lu queued\r\n",
+		CONSOLE_LINES, polled, queued);
+	uartstat();
+	irqstat();
+}
+
+#define BURST_BYTES 4096
+
+/**
+ * Polled console throughput, a byte at a time through kputc() against
+ * FIFO bursts through kwrite(), with the status reads each needed.
+ */
+void bursttest(void)
+{
+	static uchar line[64];
+	ulong start, bytes[2], reads[2];
+	int i, pass;
+
+	for (i = 0; i < 62; i++)
+		line[i] = 'a' + i % 26;
+	line[62] = '\r';
+	line[63] = '\n';
+
+	uartpoll(TRUE);
+	for (pass = 0; pass < 2; pass++)
+	{
+		reads[pass] = uartlsrreads;
+		start = clk_ns();
+		for (i = 0; i < BURST_BYTES; i++)
+		{
+			if (0 == pass)
+				kputc(line[i % 64]);
+			else if (0 == i % 64)
+				kwrite(line, 64);
+		}
+		bytes[pass] = BURST_BYTES * 1000000000UL / (clk_ns() - start);
+		reads[pass] = uartlsrreads - reads[pass];
+	}
+	uartpoll(FALSE);
+
+	kprintf("kputc(): %lu bytes/s, %lu status reads per 100 bytes\r\n",
+		bytes[0], reads[0] * 100 / BURST_BYTES);
+	kprintf("kwrite(): %lu bytes/s, %lu status reads per 100 bytes\r\n",
+		bytes[1], reads[1] * 100 / BURST_BYTES);
+}
+
+#define KTRACE_ROUNDS 1000
+
+/**
+ * Cycles per tracepoint, then a trace of two short user processes,
+ * dumped in binary for compile/ktrace2json.py.
+ */
+void ktracetest(void)
+{
+	ulong start;
+	pid_typ pid;
+	int i;
+
+	ktrace_reset();
+	start = clk_cycles();
+	for (i = 0; i < KTRACE_ROUNDS; i++)
+		ktrace(KT_USER, i, 0);
+	kprintf("ktrace(): avg %lu cycles\r\n",
+		(clk_cycles() - start) / KTRACE_ROUNDS);
+
+	ktrace_reset();
+	for (i = 0; i < 2; i++)
+	{
+		pid = create((void *)test_method, INITSTK, PRIORITY_LOW, "traced", 0);
+		if (pid != SYSERR)
+			ready(pid, RESCHED_NO);
+	}
+	start = clk_ns();
+	while (clk_ns() - start < 100000000UL)
+		;
+	kprintf("\r\nktrace dump follows\r\n");
+	ktracedump();
+	kprintf("\r\nktrace dump done\r\n");
+}
+
+#define PROFILE_NS 200000000UL
+
+static volatile ulong profsink;
+
+/**
+ * Counts loop rounds for a stretch of time.
+ * @param ns how long
+ * @return rounds
+ */
+static ulong profspin(ulong ns)
+{
+	ulong start, rounds = 0;
+
+	start = clk_ns();
+	while (clk_ns() - start < ns)
+	{
+		profsink += rounds;
+		rounds++;
+	}
+	return rounds;
+}
+
+/**
+ * User process for profiletest(): spins in user mode.
+ */
+void profuser(void)
+{
+	profspin(PROFILE_NS / 2);
+}
+
+/**
+ * Work lost to sampling every 50 us, then a profile of a user process
+ * spinning against this one, dumped for compile/profsym.py.
+ */
+void profiletest(void)
+{
+	ulong off, on;
+	pid_typ pid;
+
+	off = profspin(PROFILE_NS / 4);
+	if (SYSERR == profstart(50))
+	{
+		kprintf("profiler not built in\r\n");
+		return;
+	}
+	on = profspin(PROFILE_NS / 4);
+	profstop();
+	kprintf("sampling every 50 us: %lu rounds vs. %lu without\r\n",
+		on, off);
+
+	profstart(100);
+	pid = create((void *)profuser, INITSTK, PRIORITY_LOW, "profuser", 0);
+	if (pid != SYSERR)
+		ready(pid, RESCHED_NO);
+	profspin(PROFILE_NS);
+	kprintf("\r\nprofile dump follows\r\n");
+	profdump();
+	kprintf("\r\nprofile dump done\r\n");
+}
+
+#define CACHETEST_ORDER  4		/* 64 KiB, twice the C906 D-cache */
+#define CACHETEST_ROUNDS 16
+#define CACHETEST_ADDR   0x2000000000UL	/* uncached alias of the buffer */
+
+/**
+ * Memory-bound kernel paths with the D-cache as built (compare a build
+ * with DETAIL=-DDCACHE=0), then one buffer written through the cache and
+ * through an uncached alias, with a flush between so the two agree.
+ */
+void cachetest(void)
+{
+	pgtbl pt;
+	uchar *buf, *alias;
+	ulong len, addr, start, cached, uncached, *pte;
+	void *pg, *pg2;
+	int i;
+
+	kprintf("D-cache %s\r\n", DCACHE ? "on" : "off (DCACHE=0)");
+
+	pg = pgalloc_nozero();
+	pg2 = pgalloc_nozero();
+	if ((void *)SYSERR == pg || (void *)SYSERR == pg2)
+	{
+		kprintf("cachetest: out of memory\r\n");
+		return;
+	}
+	start = clk_cycles();
+	for (i = 0; i < CACHETEST_ROUNDS; i++)
+		pgclear(pg);
+	kprintf("pgclear(): %lu cycles per page\r\n",
+		(clk_cycles() - start) / CACHETEST_ROUNDS);
+	start = clk_cycles();
+	for (i = 0; i < CACHETEST_ROUNDS; i++)
+		pgcopy(pg2, pg);
+	kprintf("pgcopy():  %lu cycles per page\r\n",
+		(clk_cycles() - start) / CACHETEST_ROUNDS);
+	pgfree(pg2);
+	pgfree(pg);
+
+	pt = kmcache_alloc(pgtblcache);
+	if ((pgtbl)SYSERR == pt)
+	{
+		kprintf("cachetest: out of memory\r\n");
+		return;
+	}
+	len = truncpage((ulong)platform.maxaddr - (ulong)memheap);
+	start = clk_cycles();
+	mapAddress(pt, (ulong)memheap, (ulong)memheap, len,
+		   PTE_R | PTE_W | PTE_A | PTE_D);
+	unmapAddress(pt, (ulong)memheap, len);
+	kprintf("map and unmap %lu pages: %lu cycles\r\n", len / PAGE_SIZE,
+		clk_cycles() - start);
+	kmcache_free(pgtblcache, pt);
+
+	// The same frames again at CACHETEST_ADDR, with the cache bypassed
+	pt = (pgtbl)_kernpgtbl;
+	len = PAGE_SIZE << CACHETEST_ORDER;
+	buf = pgalloc_order(CACHETEST_ORDER);
+	if ((void *)SYSERR == buf
+	    || SYSERR == mapAddress(pt, CACHETEST_ADDR, (ulong)buf, len,
+				    PTE_R | PTE_W | PTE_A | PTE_D))
+	{
+		kprintf("cachetest: out of memory\r\n");
+		return;
+	}
+	alias = (uchar *)CACHETEST_ADDR;
+	for (addr = CACHETEST_ADDR; addr < CACHETEST_ADDR + len; addr += PAGE_SIZE)
+	{
+		pte = pgLookup(pt, addr);
+		*pte = (*pte & ~PTE_MEMTYPE) | PTE_NC;
+	}
+	sfence_vma();
+
+	start = clk_cycles();
+	for (i = 0; i < CACHETEST_ROUNDS; i++)
+		memset(buf, i, len);
+	cached = (clk_cycles() - start) / CACHETEST_ROUNDS;
+
+	// Nothing of the buffer may linger in the cache while the alias is used
+	dcache_flush(buf, len);
+	start = clk_cycles();
+	for (i = 0; i < CACHETEST_ROUNDS; i++)
+		memset(alias, i + 1, len);
+	uncached = (clk_cycles() - start) / CACHETEST_ROUNDS;
+
+	kprintf("memset() %lu KiB: %lu cycles cached, %lu uncached\r\n",
+		len >> 10, cached, uncached);
+	kprintf("uncached writes seen through the cache: %s\r\n",
+		(CACHETEST_ROUNDS == buf[0] && CACHETEST_ROUNDS == buf[len - 1])
+		? "PASSED" : "FAILED");
+
+	unmapAddress(pt, CACHETEST_ADDR, len);
+	pgfree_order(buf, CACHETEST_ORDER);
+}
+
 /**
  * testcases - called after initialization completes to test things.
  */
@@ -121,6 +1481,81 @@ void testcases(void)
 		case '4':
 			printPageTable(createFakeTable());
 			break;
+		case '5':
+			pgstress();
+			break;
+		case '6':
+			kprintf("create() with cold zero pool: %lu cycles\r\n",
+				createlatency(FALSE));
+			kprintf("create() with warm zero pool: %lu cycles\r\n",
+				createlatency(TRUE));
+			break;
+		case '7':
+			membench();
+			break;
+		case '8':
+			slabtest();
+			break;
+		case '9':
+			curr = create((void *)test_method, INITSTK, PRIORITY_LOW, "framedump", 0);
+			framedump();
+			kill(curr);
+			framedump();
+			break;
+		case 'a':
+			forkbench();
+			break;
+		case 'b':
+			heaptest();
+			break;
+		case 'c':
+			faulttest();
+			break;
+		case 'd':
+			unmaptest();
+			break;
+		case 'e':
+			maptest();
+			break;
+		case 'f':
+			fptest();
+			break;
+		case 'g':
+			pingpong();
+			break;
+		case 'h':
+			latencytest();
+			break;
+		case 'i':
+			vectortest();
+			break;
+		case 'j':
+			irqtracetest();
+			break;
+		case 'k':
+			ktimertest();
+			break;
+		case 'l':
+			clocktest();
+			break;
+		case 'm':
+			clknstest();
+			break;
+		case 'n':
+			consoletest();
+			break;
+		case 'o':
+			bursttest();
+			break;
+		case 'p':
+			ktracetest();
+			break;
+		case 'q':
+			profiletest();
+			break;
+		case 'r':
+			cachetest();
+			break;
 		default:
 			break;
 	}
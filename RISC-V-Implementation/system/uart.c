@@ -0,0 +1,373 @@
+/**
+ * @file uart.c
+ * @provides uartinit, uartintr, uartwake, uartputc, uartwrite, uartgetc, uartcanread, uartpoll, uartstat
+ *
+ * Interrupt-driven console on the ns16550 UART.  Output goes into a
+ * software ring that the transmitter interrupt empties into the hardware
+ * FIFO, so a writer only waits if the ring is full.  Input is gathered by
+ * the receiver interrupt into a second ring, and readers wait on a queue
+ * instead of spinning.  Until uartinit() runs, and again once uartpoll()
+ * turns polling on, every byte is written and read by polling.
+ */
+/* Embedded Xinu, Copyright (C) 2024.  All rights reserved. */
+
+#include <xinu.h>
+
+static uchar uarttx[UART_TXBUF];        /* bytes to transmit             */
+static uint txhead, txcount;
+static uchar uartrx[UART_RXBUF];        /* bytes received                */
+static uint rxhead, rxcount;
+static qid_typ uartreaders;             /* processes waiting for input   */
+
+static bool uartpolled = TRUE;          /* no interrupts; poll instead   */
+static ulong uarttxbytes;               /* bytes sent by the interrupt   */
+static ulong uartrxbytes;               /* bytes received                */
+static ulong uartrxdrop;                /* bytes lost, ring or FIFO full */
+static ulong uartwaits;                 /* writes that found ring full   */
+static ulong uartpollbytes;             /* bytes sent by polling         */
+ulong uartlsrreads;                     /* status reads while polling    */
+
+/**
+ * Waits for the transmit FIFO to empty.  With the FIFOs on, THRE means
+ * the whole FIFO is free, not just one byte of it.
+ */
+static void uartwaitthre(volatile struct ns16550_uart_csreg *regptr)
+{
+    do
+    {
+        uartlsrreads++;
+    }
+    while (0 == (regptr->lsr & UART_LSR_THRE));
+}
+
+/**
+ * Moves bytes from the transmit ring to the hardware FIFO, which is
+ * empty when this is called, and masks the transmitter interrupt once
+ * the ring is empty.  Interrupts must be off.
+ */
+static void uartfill(volatile struct ns16550_uart_csreg *regptr)
+{
+    uint n;
+
+    for (n = 0; n < UART_FIFO_LEN && txcount > 0; n++)
+    {
+        regptr->thr = uarttx[txhead];
+        txhead = (txhead + 1) % UART_TXBUF;
+        txcount--;
+    }
+    uarttxbytes += n;
+
+    if (0 == txcount)
+        regptr->ier &= ~UART_IER_ETBEI;
+}
+
+/**
+ * Sends the oldest FIFO's worth of the transmit ring by polling.
+ * Interrupts must be off.
+ */
+static void uartpushburst(volatile struct ns16550_uart_csreg *regptr)
+{
+    uint n;
+
+    uartwaitthre(regptr);
+    for (n = 0; n < UART_FIFO_LEN && txcount > 0; n++)
+    {
+        regptr->thr = uarttx[txhead];
+        txhead = (txhead + 1) % UART_TXBUF;
+        txcount--;
+    }
+    uartpollbytes += n;
+}
+
+/**
+ * Switches the console to interrupts.  Called once by sysinit(); output
+ * queues up until the kernel first enables interrupts.
+ */
+void uartinit(void)
+{
+    volatile struct ns16550_uart_csreg *regptr = platform.uart_addr;
+    ulong irq = platform.uart_irqnum;
+
+    txhead = txcount = 0;
+    rxhead = rxcount = 0;
+    uarttxbytes = uartrxbytes = uartrxdrop = uartwaits = 0;
+    uartpollbytes = uartlsrreads = 0;
+    uartreaders = newqueue();
+
+    interruptVector[irq] = uartintr;
+    softvector[SOFTIRQ_UART] = uartwake;
+
+    // PLIC priority for the UART, below the clock, and enable it for
+    // supervisor mode
+    *(volatile uint *)(PLIC_BASE + 4 * irq) = 1;
+    *(volatile uint *)(PLIC_BASE + PLIC_SIE_REGN + 4 * (irq / 32))
+        |= 1 << (irq % 32);
+
+    // Interrupt at a quarter full receive FIFO, or when input stops
+    regptr->fcr = UART_FCR_FIFOE | UART_FCR_TRIG1;
+    uartpolled = FALSE;
+    regptr->ier = UART_IER_ERBFI | UART_IER_ELSI;
+}
+
+/**
+ * Interrupt handler for the UART.  Empties the receive FIFO into the
+ * receive ring and refills the transmit FIFO from the transmit ring, for
+ * as long as the UART has anything to report.
+ */
+interrupt uartintr(void)
+{
+    volatile struct ns16550_uart_csreg *regptr = platform.uart_addr;
+    uint lsr;
+    bool got = FALSE;
+
+    while (1)
+    {
+        switch (regptr->iir & UART_IIR_IDMASK)
+        {
+        case UART_IIR_NOINT:
+            if (got && nonempty(uartreaders))
+                softraise(SOFTIRQ_UART);
+            return;
+
+        case UART_IIR_THRE:
+            uartfill(regptr);
+            break;
+
+        case UART_IIR_RLSI:
+        case UART_IIR_RDA:
+        case UART_IIR_RTO:
+            while ((lsr = regptr->lsr) & UART_LSR_DR)
+            {
+                if (lsr & UART_LSR_OE)
+                    uartrxdrop++;
+                if (rxcount < UART_RXBUF)
+                {
+                    uartrx[(rxhead + rxcount) % UART_RXBUF] = regptr->rbr;
+                    rxcount++;
+                    uartrxbytes++;
+                    got = TRUE;
+                }
+                else
+                {
+                    (void)regptr->rbr;
+                    uartrxdrop++;
+                }
+            }
+            break;
+
+        case UART_IIR_BUSY:
+            (void)*(volatile uint *)((ulong)regptr + UART_USR);
+            break;
+
+        default:
+            (void)regptr->msr;
+            break;
+        }
+    }
+}
+
+/**
+ * Bottom half of the UART interrupt: readies the processes waiting for
+ * input, to be run once the bottom halves are done.
+ */
+interrupt uartwake(void)
+{
+    irqmask im;
+
+    im = disable();
+    while (nonempty(uartreaders))
+    {
+        ready(dequeue(uartreaders), RESCHED_NO);
+        needresched = TRUE;
+    }
+    restore(im);
+}
+
+/**
+ * Queues a byte for the console.  If the ring is full, the oldest byte
+ * is sent by polling to make room, so this works in any context.
+ * @param c the byte
+ * @return c
+ */
+syscall uartputc(uchar c)
+{
+    volatile struct ns16550_uart_csreg *regptr = platform.uart_addr;
+    irqmask im;
+
+    im = disable();
+    if (uartpolled)
+    {
+        uartwaitthre(regptr);
+        regptr->thr = c;
+        uartpollbytes++;
+        restore(im);
+        return c;
+    }
+
+    if (UART_TXBUF == txcount)
+    {
+        uartwaits++;
+        uartpushburst(regptr);
+    }
+    uarttx[(txhead + txcount) % UART_TXBUF] = c;
+    txcount++;
+
+    // The interrupt comes at once if the transmitter is already idle
+    if (0 == (regptr->ier & UART_IER_ETBEI))
+        regptr->ier |= UART_IER_ETBEI;
+    restore(im);
+
+    return c;
+}
+
+/**
+ * Writes a run of bytes to the console.  Polling, it fills the whole
+ * transmit FIFO after each wait for it to empty; otherwise the bytes go
+ * into the ring in one piece, with interrupts turned off once, and a full
+ * ring is drained a FIFO's worth at a time by polling.
+ * @param buf the bytes
+ * @param len how many
+ * @return len
+ */
+syscall uartwrite(const uchar *buf, uint len)
+{
+    volatile struct ns16550_uart_csreg *regptr = platform.uart_addr;
+    uint i, n, tail;
+    irqmask im;
+
+    im = disable();
+    if (uartpolled)
+    {
+        for (i = 0; i < len; i += n)
+        {
+            uartwaitthre(regptr);
+            for (n = 0; n < UART_FIFO_LEN && i + n < len; n++)
+                regptr->thr = buf[i + n];
+        }
+        uartpollbytes += len;
+        restore(im);
+        return len;
+    }
+
+    for (i = 0; i < len; i += n)
+    {
+        if (UART_TXBUF == txcount)
+        {
+            uartwaits++;
+            uartpushburst(regptr);
+        }
+
+        // Up to the end of the free space or of the array, whichever is first
+        tail = (txhead + txcount) % UART_TXBUF;
+        n = UART_TXBUF - txcount;
+        if (n > UART_TXBUF - tail)
+            n = UART_TXBUF - tail;
+        if (n > len - i)
+            n = len - i;
+        memcpy(&uarttx[tail], &buf[i], n);
+        txcount += n;
+    }
+
+    if (0 == (regptr->ier & UART_IER_ETBEI))
+        regptr->ier |= UART_IER_ETBEI;
+    restore(im);
+
+    return len;
+}
+
+/**
+ * Reads a byte from the console.  A process waits on a queue until one
+ * arrives.  The null process may not wait, so it spins with interrupts
+ * on, and with interrupts off (or polling on) the UART is polled.
+ * @return the byte
+ */
+syscall uartgetc(void)
+{
+    volatile struct ns16550_uart_csreg *regptr = platform.uart_addr;
+    uchar c;
+    irqmask im;
+
+    im = disable();
+    while (0 == rxcount)
+    {
+        if (uartpolled || !(im & SSTATUS_SIE))
+        {
+            while (0 == (regptr->lsr & UART_LSR_DR))
+                ;
+            c = regptr->rbr;
+            restore(im);
+            return c;
+        }
+
+        if (NULLPROC == currpid)
+        {
+            restore(im);
+            im = disable();
+        }
+        else
+        {
+            proctab[currpid].state = PRWAIT;
+            enqueue(currpid, uartreaders);
+            resched();
+        }
+    }
+
+    c = uartrx[rxhead];
+    rxhead = (rxhead + 1) % UART_RXBUF;
+    rxcount--;
+    restore(im);
+
+    return c;
+}
+
+/**
+ * @return TRUE if uartgetc() has a byte ready
+ */
+bool uartcanread(void)
+{
+    volatile struct ns16550_uart_csreg *regptr = platform.uart_addr;
+
+    if (uartpolled)
+        return (regptr->lsr & UART_LSR_DR) != 0;
+    return rxcount > 0;
+}
+
+/**
+ * Switches the console between polling and interrupts.  Turning polling
+ * on sends whatever is still queued first, so output stays in order;
+ * xtrap() does this before it prints, since the system may not survive
+ * long enough for the interrupt to send it.
+ * @param on TRUE to poll, FALSE to go back to interrupts
+ */
+void uartpoll(bool on)
+{
+    volatile struct ns16550_uart_csreg *regptr = platform.uart_addr;
+    irqmask im;
+
+    im = disable();
+    if (on)
+    {
+        regptr->ier = 0;
+        while (txcount > 0)
+            uartpushburst(regptr);
+        uartpolled = TRUE;
+    }
+    else
+    {
+        uartpolled = FALSE;
+        regptr->ier = UART_IER_ERBFI | UART_IER_ELSI;
+    }
+    restore(im);
+}
+
+/**
+ * Prints the console's counters.
+ */
+void uartstat(void)
+{
+    kprintf("uart: %lu bytes sent by interrupt, %lu received, %lu lost, "
+            "%lu writes found the ring full, %u queued\r\n",
+            uarttxbytes, uartrxbytes, uartrxdrop, uartwaits, txcount);
+    kprintf("uart: %lu bytes sent by polling, %lu status reads\r\n",
+            uartpollbytes, uartlsrreads);
+}
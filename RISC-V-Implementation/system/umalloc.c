@@ -0,0 +1,122 @@
+/**
+ * @file umalloc.c
+ * @provides umalloc, ufree
+ *
+ * A small first-fit allocator for user processes.  It runs in user mode,
+ * where kernel data is read-only, so all of its state lives at the bottom
+ * of the process heap.  The heap grows through user_sbrk() and frames
+ * only appear as the blocks are touched.
+ */
+/* Embedded XINU, Copyright (C) 2024.  All rights reserved. */
+
+#include <xinu.h>
+
+/** Header in front of every block; next is only used while it is free */
+struct ublock
+{
+    ulong size;                 /**< bytes in the block, header included */
+    struct ublock *next;        /**< next free block, in address order   */
+};
+
+#define UHEAP_FREELIST (*(struct ublock **)USERHEAPADDR)
+#define UALIGN  sizeof(struct ublock)   /**< block size granularity     */
+#define UGROW   (4 * PAGE_SIZE)         /**< smallest heap extension    */
+
+/**
+ * Allocates memory from the calling process's heap.
+ * @param size number of bytes needed
+ * @return the memory, or SYSERR
+ */
+void *umalloc(ulong size)
+{
+    struct ublock *blk, *rest, **link;
+    ulong need, grow;
+
+    if (0 == size)
+    {
+        return (void *)SYSERR;
+    }
+    need = (size + sizeof(struct ublock) + UALIGN - 1) & ~(UALIGN - 1);
+
+    // The first call claims the bottom of the heap for the list head
+    if (USERHEAPADDR == (ulong)user_sbrk(0))
+    {
+        if ((void *)SYSERR == user_sbrk(UALIGN))
+            return (void *)SYSERR;
+        UHEAP_FREELIST = NULL;
+    }
+
+    while (1)
+    {
+        for (link = &UHEAP_FREELIST; (blk = *link) != NULL; link = &blk->next)
+        {
+            if (blk->size < need)
+                continue;
+
+            if (blk->size - need >= 2 * UALIGN)
+            {
+                rest = (struct ublock *)((ulong)blk + need);
+                rest->size = blk->size - need;
+                rest->next = blk->next;
+                *link = rest;
+                blk->size = need;
+            }
+            else
+            {
+                *link = blk->next;
+            }
+            return (void *)(blk + 1);
+        }
+
+        // Nothing fits; extend the heap and free the new space
+        grow = (need > UGROW) ? roundpage(need) : UGROW;
+        blk = user_sbrk(grow);
+        if ((void *)SYSERR == blk)
+            return (void *)SYSERR;
+        blk->size = grow;
+        ufree(blk + 1);
+    }
+}
+
+/**
+ * Returns memory from umalloc() to the heap, merging it with free
+ * neighbours.  The heap itself never shrinks.
+ * @param ptr pointer returned by umalloc()
+ */
+void ufree(void *ptr)
+{
+    struct ublock *blk, *prev = NULL, *next;
+
+    if (NULL == ptr || (void *)SYSERR == ptr)
+    {
+        return;
+    }
+    blk = (struct ublock *)ptr - 1;
+
+    for (next = UHEAP_FREELIST; next != NULL && next < blk; next = next->next)
+        prev = next;
+
+    if (next != NULL && (ulong)blk + blk->size == (ulong)next)
+    {
+        blk->size += next->size;
+        blk->next = next->next;
+    }
+    else
+    {
+        blk->next = next;
+    }
+
+    if (NULL == prev)
+    {
+        UHEAP_FREELIST = blk;
+    }
+    else if ((ulong)prev + prev->size == (ulong)blk)
+    {
+        prev->size += blk->size;
+        prev->next = blk->next;
+    }
+    else
+    {
+        prev->next = blk;
+    }
+}
@@ -0,0 +1,60 @@
+/**
+ * @file vm_cowfault.c
+ * @provides vm_cowfault
+ *
+ */
+/* Embedded XINU, Copyright (C) 2024.  All rights reserved. */
+
+#include <xinu.h>
+
+/**
+ * Resolves a store to a copy-on-write page left by vm_userfork().  While
+ * another address space still shares the frame, the faulting one gets a
+ * private copy; the last sharer just has write access restored.
+ * @param pagetable   the pagetable of the faulting process
+ * @param virtualaddr the address of the store, from stval
+ * @return OK if the fault is resolved and the store can be retried,
+ *         SYSERR if it was not a copy-on-write fault
+ */
+syscall vm_cowfault(pgtbl pagetable, ulong virtualaddr)
+{
+    ulong *pte;
+    ulong pa;
+    struct frame *fr;
+    void *copy;
+    irqmask im;
+
+    pte = pgLookup(pagetable, virtualaddr);
+    if (NULL == pte
+        || (*pte & (PTE_V | PTE_U | PTE_COW)) != (PTE_V | PTE_U | PTE_COW))
+    {
+        return SYSERR;
+    }
+
+    pa = PTE2PA(*pte);
+    fr = PG_FRAME(pa);
+    // Only other mappings make the frame shared.  The reference count
+    // also holds allocations, such as the stack page create() keeps in
+    // stkbase, which must not force a copy.
+    if (fr->mapcount > 1)
+    {
+        copy = pgalloc_nozero();
+        if ((void *)SYSERR == copy)
+            return SYSERR;
+        pgcopy(copy, (void *)pa);
+
+        // Move this mapping's reference from the shared frame to the copy
+        im = disable();
+        fr->mapcount--;
+        pgfree((void *)pa);
+        restore(im);
+        fr = PG_FRAME(copy);
+        fr->mapcount = 1;
+        fr->flags |= FR_USER;
+        *pte = PA2PTE(copy) | (*pte & ~PTE_PPN);
+    }
+    *pte = (*pte & ~PTE_COW) | PTE_W | PTE_D;
+    sfence_vma_page(virtualaddr, PGTBL_ASID(pagetable));
+
+    return OK;
+}
@@ -0,0 +1,115 @@
+/**
+ * @file vm_fault.c
+ * @provides vm_pagefault
+ *
+ * Resolves user page faults against the regions in pcb::vma: demand-zero
+ * pages in the heap and stack, stack growth, and copy-on-write.  A fault
+ * that only changes a mapping is counted as minor; one that has to clear
+ * or copy a frame first is counted as major.
+ */
+/* Embedded XINU, Copyright (C) 2024.  All rights reserved. */
+
+#include <xinu.h>
+#include <interrupt.h>
+
+static struct vma *vm_findvma(pcb *ppcb, ulong virtualaddr);
+
+/**
+ * Resolves a page fault taken by a user process.
+ * @param pid         the faulting process
+ * @param cause       E_INSTRUCTION_PAGEFAULT, E_LOAD_PAGEFAULT or
+ *                    E_STORE_AMO_PAGEFAULT
+ * @param virtualaddr the faulting address, from stval
+ * @return OK if the access can be retried, SYSERR if the process touched
+ *         memory it may not, or no frame is left
+ */
+syscall vm_pagefault(int pid, ulong cause, ulong virtualaddr)
+{
+    pcb *ppcb = &proctab[pid];
+    struct vma *vma;
+    ulong *pte;
+    void *pg;
+    bool zeroed;
+
+    vma = vm_findvma(ppcb, virtualaddr);
+    if (NULL == vma)
+    {
+        return SYSERR;
+    }
+
+    if ((E_INSTRUCTION_PAGEFAULT == cause && !(vma->prot & PTE_X))
+        || (E_LOAD_PAGEFAULT == cause && !(vma->prot & PTE_R))
+        || (E_STORE_AMO_PAGEFAULT == cause && !(vma->prot & PTE_W)))
+    {
+        return SYSERR;
+    }
+
+    pte = pgLookup(ppcb->pagetable, virtualaddr);
+    if (pte != NULL && (*pte & PTE_V))
+    {
+        // Only a store to a copy-on-write page is legal on a mapped page
+        if (cause != E_STORE_AMO_PAGEFAULT || !(*pte & PTE_COW))
+            return SYSERR;
+        // Counted the way vm_cowfault() decides whether to copy
+        if (PG_FRAME(PTE2PA(*pte))->mapcount > 1)
+            ppcb->majflt++;
+        else
+            ppcb->minflt++;
+        return vm_cowfault(ppcb->pagetable, virtualaddr);
+    }
+
+    // Demand-zero: a frame from the zeroed pool needs no clearing here
+    zeroed = (pgzerocount > 0);
+    pg = pgalloc();
+    if ((void *)SYSERR == pg)
+    {
+        return SYSERR;
+    }
+    PG_FRAME(pg)->owner = pid;
+
+    if (SYSERR == mapPage(ppcb->pagetable, pg, truncpage(virtualaddr),
+                          vma->prot | PTE_U | PTE_A | PTE_D, (ulong)pg))
+    {
+        pgfree(pg);
+        return SYSERR;
+    }
+
+    // The mapping holds its own reference
+    pgfree(pg);
+    sfence_vma_page(truncpage(virtualaddr), pid);
+
+    if (zeroed)
+        ppcb->minflt++;
+    else
+        ppcb->majflt++;
+
+    return OK;
+}
+
+/**
+ * Finds the region a user address belongs to.  An address below the
+ * stack, but within the process's stack length of its top, grows the
+ * stack down to it.
+ * @return the region, or NULL if the address is in none
+ */
+static struct vma *vm_findvma(pcb *ppcb, ulong virtualaddr)
+{
+    struct vma *vma;
+    uint i;
+
+    for (i = 0; i < NVMA; i++)
+    {
+        vma = &ppcb->vma[i];
+        if (virtualaddr >= vma->start && virtualaddr < roundpage(vma->end))
+            return vma;
+
+        if ((vma->flags & VMA_GROWSDOWN) && virtualaddr < vma->start
+            && vma->end - truncpage(virtualaddr) <= roundpage(ppcb->stklen))
+        {
+            vma->start = truncpage(virtualaddr);
+            return vma;
+        }
+    }
+
+    return NULL;
+}
@@ -0,0 +1,61 @@
+/**
+ * @file vm_heap.c
+ * @provides vm_brk, vm_heaprss
+ *
+ * The user heap is the VMA_HEAP region, from USERHEAPADDR up to the
+ * program break.  Moving the break only reserves or releases address
+ * space; vm_pagefault() maps a frame when the process first touches a
+ * page.
+ */
+/* Embedded XINU, Copyright (C) 2024.  All rights reserved. */
+
+#include <xinu.h>
+
+/**
+ * Moves the program break of a process.  Pages wholly above the new
+ * break are unmapped, releasing their frames and any tables left empty.
+ * @param pid  the process id
+ * @param addr the new break, within USERHEAPMAX of USERHEAPADDR
+ * @return OK, or SYSERR if the break is out of range
+ */
+syscall vm_brk(int pid, ulong addr)
+{
+    pcb *ppcb = &proctab[pid];
+    struct vma *heap = &ppcb->vma[VMA_HEAP];
+
+    if (NULL == ppcb->swaparea || addr < USERHEAPADDR
+        || addr > USERHEAPADDR + USERHEAPMAX)
+    {
+        return SYSERR;
+    }
+
+    if (roundpage(addr) < roundpage(heap->end))
+    {
+        unmapAddress(ppcb->pagetable, roundpage(addr),
+                     roundpage(heap->end) - roundpage(addr));
+    }
+
+    heap->end = addr;
+
+    return OK;
+}
+
+/**
+ * @param pid the process id
+ * @return the number of heap pages that have a frame mapped
+ */
+ulong vm_heaprss(int pid)
+{
+    pcb *ppcb = &proctab[pid];
+    ulong va, *pte, n = 0;
+
+    for (va = USERHEAPADDR; va < roundpage(ppcb->vma[VMA_HEAP].end);
+         va += PAGE_SIZE)
+    {
+        pte = pgLookup(ppcb->pagetable, va);
+        if (pte != NULL && (*pte & PTE_V))
+            n++;
+    }
+
+    return n;
+}
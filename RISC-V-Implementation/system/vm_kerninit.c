@@ -8,27 +8,49 @@
 void vm_kerninit(void)
 {
     register pcb *ppcb;
-    // Get a page to start a page table via pgalloc
-    pgtbl pagetable = pgalloc();
+    // Get a page to start a page table from the page table cache
+    pgtbl pagetable = kmcache_alloc(pgtblcache);
 
     // Map the UART
     mapAddress(pagetable, UART_BASE, UART_BASE, PAGE_SIZE, PTE_R | PTE_W | PTE_A | PTE_D);
 
-    // Map the kernel code
+#ifdef _XINU_PLATFORM_RISCV_NEZHA_
+    // Map the PLIC's priority, enable and claim registers and the timer
+    // the clock runs on; interrupts now arrive under this page table.
+    // Like the UART they lie below RAM, so mapAddress() makes them
+    // uncached devices
+    mapAddress(pagetable, PLIC_BASE, PLIC_BASE, PAGE_SIZE,
+               PTE_R | PTE_W | PTE_A | PTE_D);
+    mapAddress(pagetable, PLIC_BASE + PLIC_SIE_REGN, PLIC_BASE + PLIC_SIE_REGN,
+               PAGE_SIZE, PTE_R | PTE_W | PTE_A | PTE_D);
+    mapAddress(pagetable, PLIC_BASE + PLIC_SCLAIM_REG,
+               PLIC_BASE + PLIC_SCLAIM_REG, PAGE_SIZE,
+               PTE_R | PTE_W | PTE_A | PTE_D);
+    mapAddress(pagetable, TIMER_BASE, TIMER_BASE, PAGE_SIZE,
+               PTE_R | PTE_W | PTE_A | PTE_D);
+#endif
+
+    // Map the kernel code.  Only the trap and context switch pages are
+    // global; user page tables map the rest of the kernel with PTE_U
     mapAddress(pagetable, (ulong)&_start, (ulong)&_start,
-               ((ulong)&_ctxsws - (ulong)&_start), PTE_R | PTE_X | PTE_A | PTE_D | PTE_G);
+               ((ulong)&_ctxsws - (ulong)&_start), PTE_R | PTE_X | PTE_A | PTE_D);
 
     // Map interrupt and context switch
-    mapAddress(pagetable, (ulong)&_ctxsws, (ulong)&_ctxsws, PAGE_SIZE + PAGE_SIZE, PTE_R | PTE_X | PTE_A | PTE_D | PTE_G);
+    mapAddress(pagetable, (ulong)&_ctxsws, (ulong)&_ctxsws,
+               ((ulong)&_interrupte - (ulong)&_ctxsws), PTE_R | PTE_X | PTE_A | PTE_D | PTE_G);
 
     // Map rest of kernel code
     mapAddress(pagetable, (ulong)&_interrupte, (ulong)&_interrupte,
-               ((ulong)&_datas - (ulong)&_interrupte), PTE_R | PTE_X | PTE_A | PTE_D | PTE_G);
+               ((ulong)&_datas - (ulong)&_interrupte), PTE_R | PTE_X | PTE_A | PTE_D);
 
     // Map global kernel structures and stack
     mapAddress(pagetable, (ulong)&_datas, (ulong)&_datas,
                ((ulong)memheap - (ulong)&_datas), PTE_R | PTE_W | PTE_A | PTE_D);
 
+    // Map the clock page where clk_ns() looks for it
+    mapAddress(pagetable, CLKPAGEADDR, (ulong)clkpage, PAGE_SIZE,
+               PTE_R | PTE_A | PTE_D);
+
     // Map entirety of RAM
     mapAddress(pagetable, (ulong)memheap, (ulong)memheap,
                ((ulong)platform.maxaddr - (ulong)memheap), PTE_R | PTE_W | PTE_A | PTE_D);
@@ -37,7 +59,9 @@ void vm_kerninit(void)
     ppcb->pagetable = pagetable;
 
     _kernpgtbl = (ulong *)pagetable;
-    _kernsp = (ulong *)memheap - PAGE_SIZE - PAGE_SIZE;
+
+    // Build the kernel half that every user page table shares
+    _userpgtbl = vm_usertemplate();
 
     // Switch to the kernel page table now
     set_satp(MAKE_SATP(0, pagetable));
@@ -0,0 +1,129 @@
+/**
+ * @file vm_userfork.c
+ * @provides vm_userfork
+ *
+ */
+/* Embedded XINU, Copyright (C) 2024.  All rights reserved. */
+
+#include <xinu.h>
+
+/**
+ * Builds the address space of a forked child.  The kernel half is shared
+ * through ::_userpgtbl just as in vm_userinit().  The parent's private
+ * level 1 and level 0 tables are copied but no user page is: each
+ * writable page is made read-only and marked PTE_COW in both tables, and
+ * the shared frame gains a reference and a user mapping.  vm_cowfault()
+ * copies a page the first time either side stores to it.  The child gets
+ * its own swap area, a copy of the parent's.
+ * @param ppid the parent process id
+ * @param cpid the child process id
+ * @return the child's pagetable, or SYSERR
+ */
+pgtbl vm_userfork(int ppid, int cpid)
+{
+    pcb *parent = &proctab[ppid];
+    pcb *child = &proctab[cpid];
+    pgtbl proot = parent->pagetable;
+    pgtbl root, plvl1tbl, plvl0tbl, lvl1tbl, lvl0tbl;
+    struct frame *fr;
+    ulong *swaparea;
+    ulong pte;
+    uint i, j, k;
+    irqmask im;
+
+    child->swaparea = NULL;
+    child->pagetable = NULL;
+    if (NULL == parent->swaparea || NULL == proot || proot == _kernpgtbl)
+    {
+        return (pgtbl)SYSERR;
+    }
+
+    root = kmcache_alloc(pgtblcache);
+    if ((pgtbl)SYSERR == root)
+    {
+        return (pgtbl)SYSERR;
+    }
+    pgcopy(root, _userpgtbl);
+    PG_FRAME(root)->owner = cpid;
+    child->pagetable = root;
+
+    for (i = 0; i < PTE_PER_TBL; i++)
+    {
+        // Only the private subtrees need copying
+        if (!(proot[i] & PTE_V) || (proot[i] & PTE_LEAF)
+            || proot[i] == _userpgtbl[i])
+        {
+            continue;
+        }
+
+        lvl1tbl = kmcache_alloc(pgtblcache);
+        if ((pgtbl)SYSERR == lvl1tbl)
+            goto fail;
+        PG_FRAME(lvl1tbl)->owner = cpid;
+        root[i] = PA2PTE(lvl1tbl) | PTE_V;
+
+        plvl1tbl = (pgtbl)PTE2PA(proot[i]);
+        for (j = 0; j < PTE_PER_TBL; j++)
+        {
+            if (!(plvl1tbl[j] & PTE_V) || (plvl1tbl[j] & PTE_LEAF))
+                continue;
+
+            lvl0tbl = kmcache_alloc(pgtblcache);
+            if ((pgtbl)SYSERR == lvl0tbl)
+                goto fail;
+            PG_FRAME(lvl0tbl)->owner = cpid;
+            lvl1tbl[j] = PA2PTE(lvl0tbl) | PTE_V;
+
+            plvl0tbl = (pgtbl)PTE2PA(plvl1tbl[j]);
+            for (k = 0; k < PTE_PER_TBL; k++)
+            {
+                // The swap area mapping is kernel-only and per process
+                pte = plvl0tbl[k];
+                if ((pte & (PTE_V | PTE_U)) != (PTE_V | PTE_U))
+                    continue;
+
+                // Device memory and the like is simply shared
+                if (PG_MANAGED(PTE2PA(pte)))
+                {
+                    if (pte & PTE_W)
+                    {
+                        pte = (pte & ~PTE_W) | PTE_COW;
+                        plvl0tbl[k] = pte;
+                    }
+                    // pgref() refuses a saturated reference count.  The
+                    // entry is not in the child yet, so the teardown
+                    // leaves this frame's counts alone
+                    im = disable();
+                    if (SYSERR == pgref((void *)PTE2PA(pte)))
+                    {
+                        restore(im);
+                        goto fail;
+                    }
+                    fr = PG_FRAME(PTE2PA(pte));
+                    fr->mapcount++;
+                    restore(im);
+                }
+                lvl0tbl[k] = pte;
+            }
+        }
+    }
+
+    swaparea = kmcache_alloc(swapcache);
+    if ((ulong *)SYSERR == swaparea)
+        goto fail;
+    child->swaparea = swaparea;
+    memcpy(swaparea, parent->swaparea, CONTEXT * sizeof(ulong));
+    if (SYSERR == mapPage(root, (page)truncpage(swaparea), SWAPAREAADDR,
+                          PTE_R | PTE_W | PTE_A | PTE_D, truncpage(swaparea)))
+        goto fail;
+
+    // The parent lost write access to its pages
+    sfence_vma_asid(ppid);
+
+    return root;
+
+  fail:
+    vm_userfree(cpid);
+    sfence_vma_asid(ppid);
+    return (pgtbl)SYSERR;
+}
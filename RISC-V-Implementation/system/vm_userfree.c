@@ -0,0 +1,77 @@
+/**
+ * @file vm_userfree.c
+ * @provides vm_userfree
+ *
+ */
+/* Embedded XINU, Copyright (C) 2024.  All rights reserved. */
+
+#include <xinu.h>
+
+/**
+ * Releases the page tables and swap area of a user process, and drops
+ * the reference and user mapping count that each of its user mappings
+ * holds.  Subtrees shared with ::_userpgtbl are left alone.  A frame is
+ * only freed once nothing else refers to it, so pages still shared
+ * with a forked relative survive.
+ * @param pid the process id
+ */
+void vm_userfree(int pid)
+{
+    pcb *ppcb = &proctab[pid];
+    pgtbl root = ppcb->pagetable;
+    pgtbl lvl1tbl, lvl0tbl;
+    struct frame *fr;
+    uint i, j, k;
+    irqmask im;
+
+    if (ppcb->swaparea != NULL)
+    {
+        kmcache_free(swapcache, ppcb->swaparea);
+        ppcb->swaparea = NULL;
+    }
+
+    if (NULL == root || root == _kernpgtbl)
+    {
+        return;
+    }
+
+    for (i = 0; i < PTE_PER_TBL; i++)
+    {
+        // Skip empty entries, leaves and the shared kernel subtrees
+        if (!(root[i] & PTE_V) || (root[i] & PTE_LEAF)
+            || root[i] == _userpgtbl[i])
+        {
+            continue;
+        }
+
+        lvl1tbl = (pgtbl)PTE2PA(root[i]);
+        for (j = 0; j < PTE_PER_TBL; j++)
+        {
+            if (!(lvl1tbl[j] & PTE_V) || (lvl1tbl[j] & PTE_LEAF))
+                continue;
+
+            // Drop what the user mappings of the leaves hold
+            lvl0tbl = (pgtbl)PTE2PA(lvl1tbl[j]);
+            for (k = 0; k < PTE_PER_TBL; k++)
+            {
+                if ((lvl0tbl[k] & (PTE_V | PTE_U)) != (PTE_V | PTE_U)
+                    || !PG_MANAGED(PTE2PA(lvl0tbl[k])))
+                    continue;
+                im = disable();
+                fr = PG_FRAME(PTE2PA(lvl0tbl[k]));
+                if (fr->mapcount > 0 && 0 == --fr->mapcount)
+                    fr->flags &= ~FR_USER;
+                pgfree((void *)PTE2PA(lvl0tbl[k]));
+                restore(im);
+            }
+            kmcache_free(pgtblcache, lvl0tbl);
+        }
+        kmcache_free(pgtblcache, lvl1tbl);
+    }
+
+    kmcache_free(pgtblcache, root);
+    ppcb->pagetable = NULL;
+
+    // The pid, and so the address space id, will be used again
+    sfence_vma_asid(pid);
+}
@@ -1,6 +1,6 @@
 /**
- * @file vmcreate.c
- * @provides vmcreate
+ * @file vm_userinit.c
+ * @provides vm_userinit, vm_usertemplate
  *
  */
 /* Embedded XINU, Copyright (C) 2023.  All rights reserved. */
@@ -11,41 +11,94 @@
 extern void *end;
 
 /**
- * Creates the mappings for a user process.
- * @param pid the process id
- * @param stack the stack with any extra arguments and accounting information.  The page representing the stack is created in create.c.
- * @return the pagetable with all the mappings
+ * Builds the mappings that are the same in every user process: the UART,
+ * the kernel image and the clock page.  User page tables copy the root entries of this
+ * table, so the level 1 and level 0 tables below them are shared rather
+ * than rebuilt for every process.  Nothing per-process may be mapped
+ * inside these ranges.
+ * @return the root of the template page table
  */
-pgtbl vm_userinit(int pid, page stack)
+pgtbl vm_usertemplate(void)
 {
-    pgtbl pagetable = pgalloc();
-    pcb *ppcb = &proctab[pid];
+    pgtbl pagetable = kmcache_alloc(pgtblcache);
 
     // TODO: Once paging is working, you should be able to remove this line.  Then user processes will not be able to write to the serial driver.
 	mapAddress(pagetable, UART_BASE, UART_BASE, PAGE_SIZE, PTE_R | PTE_W | PTE_U | PTE_A | PTE_D);
 
-    // Map kernel code
+    // Map kernel code.  Not global: the kernel's own mapping of it has no PTE_U
     mapAddress(pagetable, (ulong)&_start, (ulong)&_start,
-               ((ulong)&_ctxsws - (ulong)&_start), PTE_R | PTE_X | PTE_U | PTE_A | PTE_D | PTE_G);
+               ((ulong)&_ctxsws - (ulong)&_start), PTE_R | PTE_X | PTE_U | PTE_A | PTE_D);
 
     // Map interrupt and context switch
-    mapAddress(pagetable, (ulong)&_ctxsws, (ulong)&_ctxsws, PAGE_SIZE + PAGE_SIZE, PTE_R | PTE_X | PTE_A | PTE_D | PTE_G);
+    mapAddress(pagetable, (ulong)&_ctxsws, (ulong)&_ctxsws,
+               ((ulong)&_interrupte - (ulong)&_ctxsws), PTE_R | PTE_X | PTE_A | PTE_D | PTE_G);
 
     // Map rest of kernel code
     mapAddress(pagetable, (ulong)&_interrupte, (ulong)&_interrupte,
-               ((ulong)&_datas - (ulong)&_interrupte), PTE_R | PTE_X | PTE_U | PTE_A | PTE_D | PTE_G);
+               ((ulong)&_datas - (ulong)&_interrupte), PTE_R | PTE_X | PTE_U | PTE_A | PTE_D);
                
     // Map global kernel structures and stack
     mapAddress(pagetable, (ulong)&_datas, (ulong)&_datas,
                ((ulong)memheap - (ulong)&_datas), PTE_R | PTE_U | PTE_A | PTE_D);
 
+    // Map the clock page, so clk_ns() works in user mode without a trap
+    mapAddress(pagetable, CLKPAGEADDR, (ulong)clkpage, PAGE_SIZE,
+               PTE_R | PTE_U | PTE_A | PTE_D);
+
+    return pagetable;
+}
+
+/**
+ * Creates the mappings for a user process.
+ * @param pid the process id
+ * @param stack the stack with any extra arguments and accounting information.  The page representing the stack is created in create.c.
+ * @return the pagetable with all the mappings, or SYSERR
+ */
+pgtbl vm_userinit(int pid, page stack)
+{
+    pgtbl pagetable = kmcache_alloc(pgtblcache);
+    pcb *ppcb = &proctab[pid];
+    ulong *swaparea;
+
+    ppcb->swaparea = NULL;
+    ppcb->minflt = 0;
+    ppcb->majflt = 0;
+
+    // One page of stack to start with; faults below it grow the stack
+    ppcb->vma[VMA_STACK].start = PROCSTACKADDR;
+    ppcb->vma[VMA_STACK].end = PROCSTACKADDR + PAGE_SIZE;
+    ppcb->vma[VMA_STACK].prot = PTE_R | PTE_W;
+    ppcb->vma[VMA_STACK].flags = VMA_GROWSDOWN;
+
+    // An empty heap; the program break moves its end
+    ppcb->vma[VMA_HEAP].start = USERHEAPADDR;
+    ppcb->vma[VMA_HEAP].end = USERHEAPADDR;
+    ppcb->vma[VMA_HEAP].prot = PTE_R | PTE_W;
+    ppcb->vma[VMA_HEAP].flags = 0;
+    if ((pgtbl)SYSERR == pagetable)
+    {
+        return (pgtbl)SYSERR;
+    }
+
+    // Share the kernel half with every other process
+    pgcopy(pagetable, _userpgtbl);
+    PG_FRAME(pagetable)->owner = pid;
+    PG_FRAME(stack)->owner = pid;
+
     // Map process stack
-    mapPage(pagetable, stack, PROCSTACKADDR, PTE_R | PTE_W | PTE_U | PTE_A | PTE_D, SWAPAREAADDR);
+    mapPage(pagetable, stack, PROCSTACKADDR, PTE_R | PTE_W | PTE_U | PTE_A | PTE_D, (ulong)stack);
 
-    page swaparea = pgalloc();
+    // The swap area is a slab object; map the slab page that holds it
+    swaparea = kmcache_alloc(swapcache);
+    if ((ulong *)SYSERR == swaparea)
+    {
+        ppcb->pagetable = pagetable;
+        vm_userfree(pid);
+        return (pgtbl)SYSERR;
+    }
     ppcb->swaparea = swaparea;
-    ppcb->swaparea[CTX_KERNSP] = (ulong)_kernsp;
-    mapPage(pagetable, swaparea, SWAPAREAADDR, PTE_R | PTE_W | PTE_A | PTE_D, SWAPAREAADDR);
+    swaparea[CTX_KERNSATP] = MAKE_SATP(0, _kernpgtbl);
+    mapPage(pagetable, (page)truncpage(swaparea), SWAPAREAADDR, PTE_R | PTE_W | PTE_A | PTE_D, truncpage(swaparea));
 
     return pagetable;
 }
@@ -23,6 +23,8 @@ char *trap_names[] = {
 void xtrap(ulong *frame, ulong cause, ulong address, ulong *pc)
 {
     /* If not an interrupt or syscall, fall through to generic exception handler */
+    // Nothing may be left to the UART interrupt from here on
+    uartpoll(TRUE);
     kprintf("\r\n\r\nXINU Exception [%s]\r\n", trap_names[cause]);
     kprintf("Faulting code: 0x%016lX\r\n", pc);
 
@@ -30,6 +32,12 @@ void xtrap(ulong *frame, ulong cause, ulong address, ulong *pc)
         kprintf("Faulting address: 0x%016lX\r\n", address);
     }
 
+    if (NULL == frame)
+    {
+        while (1)
+            ;                   /* forever */
+    }
+
     kprintf("[0x%016lX]  t4:0x%016lX   t5:0x%016lX  t6:0x%016lX\r\n",
             frame + CTX_T4,
             frame[CTX_T4], frame[CTX_T5], frame[CTX_T6]); 